@@ -0,0 +1,105 @@
+#include "ConcurrentHyperLogLog.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// Threads take consecutive slots on first use, so up to `shards` threads land
+// on distinct shards. Threads that share a shard stay correct through the CAS.
+// The slot is constant-initialized and assigned lazily, which keeps the hot
+// path free of a thread_local init guard.
+static std::atomic<std::size_t> next_slot{0};
+static thread_local std::size_t thread_slot = SIZE_MAX;
+
+static std::size_t threadSlot() {
+    if (thread_slot == SIZE_MAX) {
+        thread_slot = next_slot.fetch_add(1, std::memory_order_relaxed);
+    }
+    return thread_slot;
+}
+
+static std::size_t roundUpPow2(std::size_t x) {
+    std::size_t p = 1;
+    while (p < x) {
+        p <<= 1;
+    }
+    return p;
+}
+
+ConcurrentHyperLogLog::ConcurrentHyperLogLog(int b, std::uint32_t seed,
+                                             HashKind hash, std::size_t shards)
+    : b_(b)
+    , m_(1ULL << b)
+    , seed_(seed)
+    , hash_(hash)
+    , hash_bits_(HashFuncGen::hashBits(hash))
+    , shards_(roundUpPow2(shards > 0 ? shards
+                                     : std::max(1u, std::thread::hardware_concurrency())))
+    , shard_shift_(std::max(b, 6)) {
+    if (b < 4 || b > HyperLogLog::maxPrecision(hash)) {
+        throw std::invalid_argument(hash_bits_ == 32 ? "b must be in [4, 16]"
+                                                     : "b must be in [4, 24]");
+    }
+    // Shards are 2^shard_shift_ >= 64 bytes apart, starting at a line
+    // boundary inside the over-allocated block.
+    registers_.reset(new std::atomic<std::uint8_t>[(shards_ << shard_shift_) + kCacheLine]);
+    std::size_t misalign = reinterpret_cast<std::uintptr_t>(registers_.get()) % kCacheLine;
+    base_ = registers_.get() + (misalign ? kCacheLine - misalign : 0);
+    reset();
+}
+
+void ConcurrentHyperLogLog::updateRegister(std::size_t index,
+                                           std::uint8_t rank) {
+    std::atomic<std::uint8_t>& reg = this->reg(threadSlot() & (shards_ - 1), index);
+    std::uint8_t cur = reg.load(std::memory_order_relaxed);
+    while (rank > cur &&
+           !reg.compare_exchange_weak(cur, rank, std::memory_order_relaxed)) {
+    }
+}
+
+void ConcurrentHyperLogLog::addHash(std::uint64_t hash) {
+    int q = hash_bits_ - b_;
+    std::size_t index = static_cast<std::size_t>(hash >> q) & (m_ - 1);
+    int r = HyperLogLog::rho(hash & ((1ULL << q) - 1), q);
+    updateRegister(index, static_cast<std::uint8_t>(r));
+}
+
+void ConcurrentHyperLogLog::add(std::string_view element) {
+    addHash(HashFuncGen::hash(hash_, element, seed_));
+}
+
+void ConcurrentHyperLogLog::addBatch(const std::string_view* keys,
+                                     std::size_t n) {
+    std::uint64_t hashes[64];
+    for (std::size_t i = 0; i < n; i += 64) {
+        std::size_t len = std::min<std::size_t>(64, n - i);
+        HashFuncGen::hashBatch(hash_, keys + i, len, seed_, hashes);
+        for (std::size_t j = 0; j < len; ++j) {
+            addHash(hashes[j]);
+        }
+    }
+}
+
+HyperLogLog ConcurrentHyperLogLog::snapshot() const {
+    std::vector<std::uint8_t> regs(m_, 0);
+    for (std::size_t s = 0; s < shards_; ++s) {
+        for (std::size_t i = 0; i < m_; ++i) {
+            regs[i] = std::max(regs[i], reg(s, i).load(std::memory_order_relaxed));
+        }
+    }
+    HyperLogLog h(b_, seed_, hash_);
+    h.mergeRegisters(regs.data(), regs.size());
+    return h;
+}
+
+double ConcurrentHyperLogLog::estimate() const {
+    return snapshot().estimate();
+}
+
+void ConcurrentHyperLogLog::reset() {
+    for (std::size_t s = 0; s < shards_; ++s) {
+        for (std::size_t i = 0; i < m_; ++i) {
+            reg(s, i).store(0, std::memory_order_relaxed);
+        }
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include "HashFuncGen.hpp"
+#include "HyperLogLog.hpp"
+
+// Each thread writes to its own shard of registers, and snapshot() merges the
+// shards with max. Shards are cache-line aligned, so threads on different
+// shards never write to the same line. shards = 0 means one per hardware
+// thread; the count is rounded up to a power of two.
+class ConcurrentHyperLogLog {
+public:
+    explicit ConcurrentHyperLogLog(int b, std::uint32_t seed = 0x9747b28c,
+                                   HashKind hash = HashKind::Murmur3_32,
+                                   std::size_t shards = 0);
+
+    void add(std::string_view element);
+
+    void addHash(std::uint64_t hash);
+
+    void addBatch(const std::string_view* keys, std::size_t n);
+
+    HyperLogLog snapshot() const;
+
+    double estimate() const;
+
+    void reset();
+
+    std::size_t shards() const {
+        return shards_;
+    }
+
+private:
+    static constexpr std::size_t kCacheLine = 64;
+
+    int b_;
+    std::size_t m_;
+    std::uint32_t seed_;
+    HashKind hash_;
+    int hash_bits_;
+    std::size_t shards_;
+    int shard_shift_;
+    std::unique_ptr<std::atomic<std::uint8_t>[]> registers_;
+    std::atomic<std::uint8_t>* base_;
+
+    std::atomic<std::uint8_t>& reg(std::size_t shard, std::size_t index) const {
+        return base_[(shard << shard_shift_) + index];
+    }
+
+    void updateRegister(std::size_t index, std::uint8_t rank);
+};
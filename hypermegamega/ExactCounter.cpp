@@ -0,0 +1,9 @@
+#include "ExactCounter.hpp"
+
+void ExactCounter::add(std::string_view element) {
+    set_.emplace(element);
+}
+
+void ExactCounter::reset() {
+    set_.clear();
+}
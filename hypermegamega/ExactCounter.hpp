@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+class ExactCounter {
+public:
+    void add(std::string_view element);
+
+    std::size_t count() const {
+        return set_.size();
+    }
+
+    void reset();
+
+private:
+    std::unordered_set<std::string> set_;
+};
@@ -0,0 +1,138 @@
+#include "ExperimentRunner.hpp"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include "ExactCounter.hpp"
+#include "HyperLogLog.hpp"
+#include "HyperLogLogAvg.hpp"
+#include "RandomStreamGen.hpp"
+
+// Everything that runStream would reject is checked here, on the caller's
+// thread, so that a bad configuration never throws inside a worker.
+ExperimentRunner::ExperimentRunner(ExperimentConfig config)
+    : config_(std::move(config)) {
+    if (config_.k == 0) {
+        throw std::invalid_argument("k must be positive");
+    }
+    if (config_.num_streams == 0 || config_.stream_size == 0) {
+        throw std::invalid_argument("num_streams and stream_size must be positive");
+    }
+    if (config_.prefixes.empty() ||
+        !std::is_sorted(config_.prefixes.begin(), config_.prefixes.end()) ||
+        !(config_.prefixes.front() > 0.0) || !(config_.prefixes.back() <= 1.0)) {
+        throw std::invalid_argument("prefixes must be ascending in (0, 1]");
+    }
+    HyperLogLog probe(config_.b, 0x9747b28c, config_.hash);
+    HyperLogLogAvg avg_probe(config_.b, 1, 0x9747b28c, config_.avg_hash);
+
+    if (!config_.key_file.empty())
+        keys_ = RandomStreamGen::readKeys(config_.key_file);
+    RandomStreamGen gen(config_.seed);
+    if (keys_)
+        gen.setKeys(keys_);
+    gen.setProfile(config_.workload);
+    if (config_.stream_size > UINT32_MAX / gen.maxLength()) {
+        throw std::invalid_argument("stream_size too large for 32-bit key offsets");
+    }
+}
+
+unsigned int ExperimentRunner::streamSeed(unsigned int base_seed,
+                                          std::size_t stream_idx) {
+    std::uint64_t x = (static_cast<std::uint64_t>(base_seed) << 32) + stream_idx;
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return static_cast<unsigned int>(x);
+}
+
+StreamEstimates ExperimentRunner::runStream(std::size_t stream_idx) const {
+    RandomStreamGen gen(streamSeed(config_.seed, stream_idx));
+    if (keys_)
+        gen.setKeys(keys_);
+    gen.setProfile(config_.workload);
+    HyperLogLog hll(config_.b, 0x9747b28c, config_.hash);
+    HyperLogLogAvg hll_avg(config_.b, config_.k, 0x9747b28c, config_.avg_hash);
+    ExactCounter exact;
+
+    std::vector<char> data;
+    std::vector<std::uint32_t> offsets;
+    gen.generateInto(config_.stream_size, data, offsets);
+
+    StreamEstimates result;
+    result.base.reserve(config_.prefixes.size());
+    result.avg.reserve(config_.prefixes.size());
+    result.exact.reserve(config_.prefixes.size());
+
+    std::size_t prev_size = 0;
+    for (double p : config_.prefixes) {
+        std::size_t prefix_size =
+            static_cast<std::size_t>(config_.stream_size * p);
+
+        hll.addBatch(data.data(), offsets.data() + prev_size,
+                     prefix_size - prev_size);
+        for (std::size_t i = prev_size; i < prefix_size; ++i) {
+            std::string_view key(data.data() + offsets[i],
+                                 offsets[i + 1] - offsets[i]);
+            hll_avg.add(key);
+            exact.add(key);
+        }
+        prev_size = prefix_size;
+
+        result.base.push_back(hll.estimate());
+        result.avg.push_back(hll_avg.estimateMean());
+        result.exact.push_back(exact.count());
+    }
+    return result;
+}
+
+std::vector<StreamEstimates> ExperimentRunner::runAll(
+    unsigned int threads,
+    const std::function<void(std::size_t)>& on_progress) const {
+    std::vector<StreamEstimates> results(config_.num_streams);
+    std::atomic<std::size_t> next{0};
+    std::size_t done = 0;
+    std::mutex progress_mutex;
+    std::exception_ptr error;
+
+    // An exception must not leave a std::thread: the first one stops the
+    // remaining streams and is rethrown after join.
+    auto worker = [&]() {
+        for (;;) {
+            std::size_t idx = next.fetch_add(1);
+            if (idx >= config_.num_streams)
+                return;
+            try {
+                results[idx] = runStream(idx);
+                if (on_progress) {
+                    std::lock_guard<std::mutex> lock(progress_mutex);
+                    on_progress(++done);
+                }
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(progress_mutex);
+                if (!error)
+                    error = std::current_exception();
+                next = config_.num_streams;
+                return;
+            }
+        }
+    };
+
+    threads = static_cast<unsigned int>(
+        std::min<std::size_t>(std::max(1u, threads), config_.num_streams));
+    std::vector<std::thread> pool;
+    for (unsigned int t = 1; t < threads; ++t) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& t : pool) {
+        t.join();
+    }
+    if (error)
+        std::rethrow_exception(error);
+    return results;
+}
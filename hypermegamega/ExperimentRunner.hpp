@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "HashFuncGen.hpp"
+#include "RandomStreamGen.hpp"
+
+struct ExperimentConfig {
+    int b = 12;
+    std::size_t k = 7;
+    std::size_t stream_size = 10000;
+    std::size_t num_streams = 100;
+    unsigned int seed = 42;
+    HashKind hash = HashKind::Murmur3_32;
+    // Base hash of the averaged sketches; must be a 64-bit kind.
+    HashKind avg_hash = HashKind::WyHash64;
+    RandomStreamGen::Profile workload;
+    std::string key_file;
+    std::vector<double> prefixes;
+};
+
+struct StreamEstimates {
+    std::vector<double> base;
+    std::vector<double> avg;
+    std::vector<std::size_t> exact;
+};
+
+class ExperimentRunner {
+public:
+    explicit ExperimentRunner(ExperimentConfig config);
+
+    StreamEstimates runStream(std::size_t stream_idx) const;
+
+    std::vector<StreamEstimates> runAll(
+        unsigned int threads,
+        const std::function<void(std::size_t)>& on_progress = {}) const;
+
+    static unsigned int streamSeed(unsigned int base_seed,
+                                   std::size_t stream_idx);
+
+    const ExperimentConfig& config() const {
+        return config_;
+    }
+
+private:
+    ExperimentConfig config_;
+    std::shared_ptr<const RandomStreamGen::KeySet> keys_;
+};
@@ -1,6 +1,11 @@
 #include "HashFuncGen.hpp"
+#include <algorithm>
+#include <cstring>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#endif
 
-uint32_t HashFuncGen::murmur3_32(const std::string& key, uint32_t seed) {
+uint32_t HashFuncGen::murmur3_32(std::string_view key, uint32_t seed) {
     const uint8_t* data = reinterpret_cast<const uint8_t*>(key.data());
     size_t len = key.size();
     uint32_t h = seed;
@@ -52,11 +57,579 @@ uint32_t HashFuncGen::murmur3_32(const std::string& key, uint32_t seed) {
     return h;
 }
 
-uint32_t HashFuncGen::fnv1a_32(const std::string& key) {
+static inline uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t read64(const uint8_t* p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t read32(const uint8_t* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t fmix64(uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+}
+
+void HashFuncGen::murmur3_x64_128(std::string_view key, uint32_t seed,
+                                  uint64_t out[2]) {
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(key.data());
+    const size_t len = key.size();
+    const size_t nblocks = len / 16;
+    uint64_t h1 = seed;
+    uint64_t h2 = seed;
+    const uint64_t c1 = 0x87c37b91114253d5ULL;
+    const uint64_t c2 = 0x4cf5ad432745937fULL;
+
+    for (size_t i = 0; i < nblocks; ++i) {
+        uint64_t k1 = read64(data + i * 16);
+        uint64_t k2 = read64(data + i * 16 + 8);
+
+        k1 *= c1;
+        k1 = rotl64(k1, 31);
+        k1 *= c2;
+        h1 ^= k1;
+        h1 = rotl64(h1, 27);
+        h1 += h2;
+        h1 = h1 * 5 + 0x52dce729;
+
+        k2 *= c2;
+        k2 = rotl64(k2, 33);
+        k2 *= c1;
+        h2 ^= k2;
+        h2 = rotl64(h2, 31);
+        h2 += h1;
+        h2 = h2 * 5 + 0x38495ab5;
+    }
+
+    const uint8_t* tail = data + nblocks * 16;
+    uint64_t k1 = 0;
+    uint64_t k2 = 0;
+    switch (len & 15) {
+    case 15:
+        k2 ^= static_cast<uint64_t>(tail[14]) << 48;
+        [[fallthrough]];
+    case 14:
+        k2 ^= static_cast<uint64_t>(tail[13]) << 40;
+        [[fallthrough]];
+    case 13:
+        k2 ^= static_cast<uint64_t>(tail[12]) << 32;
+        [[fallthrough]];
+    case 12:
+        k2 ^= static_cast<uint64_t>(tail[11]) << 24;
+        [[fallthrough]];
+    case 11:
+        k2 ^= static_cast<uint64_t>(tail[10]) << 16;
+        [[fallthrough]];
+    case 10:
+        k2 ^= static_cast<uint64_t>(tail[9]) << 8;
+        [[fallthrough]];
+    case 9:
+        k2 ^= static_cast<uint64_t>(tail[8]);
+        k2 *= c2;
+        k2 = rotl64(k2, 33);
+        k2 *= c1;
+        h2 ^= k2;
+        [[fallthrough]];
+    case 8:
+        k1 ^= static_cast<uint64_t>(tail[7]) << 56;
+        [[fallthrough]];
+    case 7:
+        k1 ^= static_cast<uint64_t>(tail[6]) << 48;
+        [[fallthrough]];
+    case 6:
+        k1 ^= static_cast<uint64_t>(tail[5]) << 40;
+        [[fallthrough]];
+    case 5:
+        k1 ^= static_cast<uint64_t>(tail[4]) << 32;
+        [[fallthrough]];
+    case 4:
+        k1 ^= static_cast<uint64_t>(tail[3]) << 24;
+        [[fallthrough]];
+    case 3:
+        k1 ^= static_cast<uint64_t>(tail[2]) << 16;
+        [[fallthrough]];
+    case 2:
+        k1 ^= static_cast<uint64_t>(tail[1]) << 8;
+        [[fallthrough]];
+    case 1:
+        k1 ^= static_cast<uint64_t>(tail[0]);
+        k1 *= c1;
+        k1 = rotl64(k1, 31);
+        k1 *= c2;
+        h1 ^= k1;
+    }
+
+    h1 ^= static_cast<uint64_t>(len);
+    h2 ^= static_cast<uint64_t>(len);
+    h1 += h2;
+    h2 += h1;
+    h1 = fmix64(h1);
+    h2 = fmix64(h2);
+    h1 += h2;
+    h2 += h1;
+
+    out[0] = h1;
+    out[1] = h2;
+}
+
+static inline uint32_t murmur3_32_tail(const uint8_t* tail, size_t rem) {
+    uint32_t k = 0;
+    switch (rem) {
+    case 3:
+        k ^= static_cast<uint32_t>(tail[2]) << 16;
+        [[fallthrough]];
+    case 2:
+        k ^= static_cast<uint32_t>(tail[1]) << 8;
+        [[fallthrough]];
+    case 1:
+        k ^= static_cast<uint32_t>(tail[0]);
+    }
+    return k;
+}
+
+static void murmur3_32_batch_scalar(const std::string_view* keys, size_t n,
+                                    uint32_t seed, uint32_t* out) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = HashFuncGen::murmur3_32(keys[i], seed);
+    }
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HASHFUNCGEN_X86_KERNELS 1
+
+__attribute__((target("avx2"))) static inline __m256i rotl32_avx2(__m256i x,
+                                                                  int r) {
+    return _mm256_or_si256(_mm256_slli_epi32(x, r), _mm256_srli_epi32(x, 32 - r));
+}
+
+// Loads the first 8 blocks of 8 keys and transposes them so that cols[j]
+// holds block j of every key. Masked loads never touch bytes past a key's
+// last full block, so short keys at the end of a page are safe.
+__attribute__((target("avx2"))) static inline void
+load_blocks_x8(const std::string_view* keys, const uint32_t* nblocks,
+               __m256i cols[8]) {
+    const __m256i iota = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256i r[8];
+    for (int l = 0; l < 8; ++l) {
+        __m256i mask = _mm256_cmpgt_epi32(
+            _mm256_set1_epi32(static_cast<int>(nblocks[l])), iota);
+        r[l] = _mm256_maskload_epi32(reinterpret_cast<const int*>(keys[l].data()),
+                                     mask);
+    }
+
+    __m256i t0 = _mm256_unpacklo_epi32(r[0], r[1]);
+    __m256i t1 = _mm256_unpackhi_epi32(r[0], r[1]);
+    __m256i t2 = _mm256_unpacklo_epi32(r[2], r[3]);
+    __m256i t3 = _mm256_unpackhi_epi32(r[2], r[3]);
+    __m256i t4 = _mm256_unpacklo_epi32(r[4], r[5]);
+    __m256i t5 = _mm256_unpackhi_epi32(r[4], r[5]);
+    __m256i t6 = _mm256_unpacklo_epi32(r[6], r[7]);
+    __m256i t7 = _mm256_unpackhi_epi32(r[6], r[7]);
+
+    __m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+    __m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+    __m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+    __m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+    __m256i u4 = _mm256_unpacklo_epi64(t4, t6);
+    __m256i u5 = _mm256_unpackhi_epi64(t4, t6);
+    __m256i u6 = _mm256_unpacklo_epi64(t5, t7);
+    __m256i u7 = _mm256_unpackhi_epi64(t5, t7);
+
+    cols[0] = _mm256_permute2x128_si256(u0, u4, 0x20);
+    cols[1] = _mm256_permute2x128_si256(u1, u5, 0x20);
+    cols[2] = _mm256_permute2x128_si256(u2, u6, 0x20);
+    cols[3] = _mm256_permute2x128_si256(u3, u7, 0x20);
+    cols[4] = _mm256_permute2x128_si256(u0, u4, 0x31);
+    cols[5] = _mm256_permute2x128_si256(u1, u5, 0x31);
+    cols[6] = _mm256_permute2x128_si256(u2, u6, 0x31);
+    cols[7] = _mm256_permute2x128_si256(u3, u7, 0x31);
+}
+
+// Fills lens/nblocks/tails for a group of keys; returns the largest block
+// count so the caller can fall back to scalar code when some key has more
+// than 8 four-byte blocks, i.e. is longer than 35 bytes.
+static inline uint32_t prepare_group(const std::string_view* keys, int lanes,
+                                     uint32_t* lens, uint32_t* nblocks,
+                                     uint32_t* tails) {
+    uint32_t max_blocks = 0;
+    for (int l = 0; l < lanes; ++l) {
+        const uint8_t* data = reinterpret_cast<const uint8_t*>(keys[l].data());
+        lens[l] = static_cast<uint32_t>(keys[l].size());
+        nblocks[l] = lens[l] / 4;
+        tails[l] = murmur3_32_tail(data + 4 * nblocks[l], lens[l] & 3);
+        max_blocks = std::max(max_blocks, nblocks[l]);
+    }
+    return max_blocks;
+}
+
+__attribute__((target("avx2"))) static void
+murmur3_32_batch_avx2(const std::string_view* keys, size_t n, uint32_t seed,
+                      uint32_t* out) {
+    const __m256i c1 = _mm256_set1_epi32(static_cast<int>(0xcc9e2d51u));
+    const __m256i c2 = _mm256_set1_epi32(static_cast<int>(0x1b873593u));
+    const __m256i c3 = _mm256_set1_epi32(static_cast<int>(0xe6546b64u));
+    const __m256i f1 = _mm256_set1_epi32(static_cast<int>(0x85ebca6bu));
+    const __m256i f2 = _mm256_set1_epi32(static_cast<int>(0xc2b2ae35u));
+    const __m256i five = _mm256_set1_epi32(5);
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        alignas(32) uint32_t lens[8];
+        alignas(32) uint32_t nblocks[8];
+        alignas(32) uint32_t tails[8];
+        uint32_t max_blocks = prepare_group(keys + i, 8, lens, nblocks, tails);
+        if (max_blocks > 8) {
+            murmur3_32_batch_scalar(keys + i, 8, seed, out + i);
+            continue;
+        }
+
+        __m256i cols[8];
+        load_blocks_x8(keys + i, nblocks, cols);
+        const __m256i vblocks =
+            _mm256_load_si256(reinterpret_cast<const __m256i*>(nblocks));
+
+        __m256i h = _mm256_set1_epi32(static_cast<int>(seed));
+        for (uint32_t j = 0; j < max_blocks; ++j) {
+            __m256i k = _mm256_mullo_epi32(cols[j], c1);
+            k = rotl32_avx2(k, 15);
+            k = _mm256_mullo_epi32(k, c2);
+            __m256i hn = _mm256_xor_si256(h, k);
+            hn = rotl32_avx2(hn, 13);
+            hn = _mm256_add_epi32(_mm256_mullo_epi32(hn, five), c3);
+            __m256i active = _mm256_cmpgt_epi32(
+                vblocks, _mm256_set1_epi32(static_cast<int>(j)));
+            h = _mm256_blendv_epi8(h, hn, active);
+        }
+
+        __m256i k = _mm256_load_si256(reinterpret_cast<const __m256i*>(tails));
+        __m256i has_tail = _mm256_cmpgt_epi32(k, _mm256_setzero_si256());
+        k = _mm256_mullo_epi32(k, c1);
+        k = rotl32_avx2(k, 15);
+        k = _mm256_mullo_epi32(k, c2);
+        h = _mm256_xor_si256(h, _mm256_and_si256(k, has_tail));
+
+        h = _mm256_xor_si256(
+            h, _mm256_load_si256(reinterpret_cast<const __m256i*>(lens)));
+        h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 16));
+        h = _mm256_mullo_epi32(h, f1);
+        h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 13));
+        h = _mm256_mullo_epi32(h, f2);
+        h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 16));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), h);
+    }
+    murmur3_32_batch_scalar(keys + i, n - i, seed, out + i);
+}
+
+// GCC implements the unmasked shifts, rotates and inserts as their masked
+// forms merged into _mm512_undefined_epi32(), which -Wmaybe-uninitialized
+// reports. The full-mask zeroing forms compute the same lanes without it.
+template <int R>
+__attribute__((target("avx512f"))) static inline __m512i rotl32_avx512(__m512i x) {
+    return _mm512_maskz_rol_epi32(0xFFFF, x, R);
+}
+
+template <int R>
+__attribute__((target("avx512f"))) static inline __m512i srli32_avx512(__m512i x) {
+    return _mm512_maskz_srli_epi32(0xFFFF, x, R);
+}
+
+__attribute__((target("avx512f"))) static inline __m512i concat_avx512(__m256i lo,
+                                                                      __m256i hi) {
+    const __m512i base = _mm512_castsi256_si512(lo);
+    return _mm512_mask_inserti64x4(base, 0xFF, base, hi, 1);
+}
+
+__attribute__((target("avx512f"))) static void
+murmur3_32_batch_avx512(const std::string_view* keys, size_t n, uint32_t seed,
+                        uint32_t* out) {
+    const __m512i c1 = _mm512_set1_epi32(static_cast<int>(0xcc9e2d51u));
+    const __m512i c2 = _mm512_set1_epi32(static_cast<int>(0x1b873593u));
+    const __m512i c3 = _mm512_set1_epi32(static_cast<int>(0xe6546b64u));
+    const __m512i f1 = _mm512_set1_epi32(static_cast<int>(0x85ebca6bu));
+    const __m512i f2 = _mm512_set1_epi32(static_cast<int>(0xc2b2ae35u));
+    const __m512i five = _mm512_set1_epi32(5);
+
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        alignas(64) uint32_t lens[16];
+        alignas(64) uint32_t nblocks[16];
+        alignas(64) uint32_t tails[16];
+        uint32_t max_blocks = prepare_group(keys + i, 16, lens, nblocks, tails);
+        if (max_blocks > 8) {
+            murmur3_32_batch_scalar(keys + i, 16, seed, out + i);
+            continue;
+        }
+
+        __m256i lo[8];
+        __m256i hi[8];
+        load_blocks_x8(keys + i, nblocks, lo);
+        load_blocks_x8(keys + i + 8, nblocks + 8, hi);
+        const __m512i vblocks = _mm512_load_si512(nblocks);
+
+        __m512i h = _mm512_set1_epi32(static_cast<int>(seed));
+        for (uint32_t j = 0; j < max_blocks; ++j) {
+            __m512i k = concat_avx512(lo[j], hi[j]);
+            k = _mm512_mullo_epi32(k, c1);
+            k = rotl32_avx512<15>(k);
+            k = _mm512_mullo_epi32(k, c2);
+            __m512i hn = _mm512_xor_si512(h, k);
+            hn = rotl32_avx512<13>(hn);
+            hn = _mm512_add_epi32(_mm512_mullo_epi32(hn, five), c3);
+            __mmask16 active = _mm512_cmpgt_epu32_mask(
+                vblocks, _mm512_set1_epi32(static_cast<int>(j)));
+            h = _mm512_mask_mov_epi32(h, active, hn);
+        }
+
+        __m512i k = _mm512_load_si512(tails);
+        __mmask16 has_tail = _mm512_test_epi32_mask(k, k);
+        k = _mm512_mullo_epi32(k, c1);
+        k = rotl32_avx512<15>(k);
+        k = _mm512_mullo_epi32(k, c2);
+        h = _mm512_mask_xor_epi32(h, has_tail, h, k);
+
+        h = _mm512_xor_si512(h, _mm512_load_si512(lens));
+        h = _mm512_xor_si512(h, srli32_avx512<16>(h));
+        h = _mm512_mullo_epi32(h, f1);
+        h = _mm512_xor_si512(h, srli32_avx512<13>(h));
+        h = _mm512_mullo_epi32(h, f2);
+        h = _mm512_xor_si512(h, srli32_avx512<16>(h));
+        _mm512_storeu_si512(out + i, h);
+    }
+    murmur3_32_batch_avx2(keys + i, n - i, seed, out + i);
+}
+#endif
+
+using Murmur3BatchFn = void (*)(const std::string_view*, size_t, uint32_t,
+                                uint32_t*);
+
+static Murmur3BatchFn select_murmur3_32_batch() {
+#ifdef HASHFUNCGEN_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return murmur3_32_batch_avx512;
+    if (__builtin_cpu_supports("avx2"))
+        return murmur3_32_batch_avx2;
+#endif
+    return murmur3_32_batch_scalar;
+}
+
+void HashFuncGen::murmur3_32_batch(const std::string_view* keys, size_t n,
+                                   uint32_t seed, uint32_t* out) {
+    static const Murmur3BatchFn kernel = select_murmur3_32_batch();
+    kernel(keys, n, seed, out);
+}
+
+uint64_t HashFuncGen::xxh64(std::string_view key, uint64_t seed) {
+    const uint64_t p1 = 0x9E3779B185EBCA87ULL;
+    const uint64_t p2 = 0xC2B2AE3D27D4EB4FULL;
+    const uint64_t p3 = 0x165667B19E3779F9ULL;
+    const uint64_t p4 = 0x85EBCA77C2B2AE63ULL;
+    const uint64_t p5 = 0x27D4EB2F165667C5ULL;
+
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(key.data());
+    const uint8_t* end = p + key.size();
+    uint64_t h;
+
+    auto round = [&](uint64_t acc, uint64_t input) {
+        acc += input * p2;
+        acc = rotl64(acc, 31);
+        return acc * p1;
+    };
+    auto merge_round = [&](uint64_t acc, uint64_t val) {
+        acc ^= round(0, val);
+        return acc * p1 + p4;
+    };
+
+    if (key.size() >= 32) {
+        uint64_t v1 = seed + p1 + p2;
+        uint64_t v2 = seed + p2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - p1;
+        const uint8_t* limit = end - 32;
+        do {
+            v1 = round(v1, read64(p));
+            v2 = round(v2, read64(p + 8));
+            v3 = round(v3, read64(p + 16));
+            v4 = round(v4, read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = merge_round(h, v1);
+        h = merge_round(h, v2);
+        h = merge_round(h, v3);
+        h = merge_round(h, v4);
+    } else {
+        h = seed + p5;
+    }
+
+    h += static_cast<uint64_t>(key.size());
+
+    while (p + 8 <= end) {
+        h ^= round(0, read64(p));
+        h = rotl64(h, 27) * p1 + p4;
+        p += 8;
+    }
+    if (p + 4 <= end) {
+        h ^= static_cast<uint64_t>(read32(p)) * p1;
+        h = rotl64(h, 23) * p2 + p3;
+        p += 4;
+    }
+    while (p < end) {
+        h ^= static_cast<uint64_t>(*p) * p5;
+        h = rotl64(h, 11) * p1;
+        ++p;
+    }
+
+    h ^= h >> 33;
+    h *= p2;
+    h ^= h >> 29;
+    h *= p3;
+    h ^= h >> 32;
+    return h;
+}
+
+// Full 64x64 -> 128-bit product: low half into a, high half into b.
+static inline void wymum(uint64_t& a, uint64_t& b) {
+#ifdef __SIZEOF_INT128__
+    __uint128_t r = static_cast<__uint128_t>(a) * b;
+    a = static_cast<uint64_t>(r);
+    b = static_cast<uint64_t>(r >> 64);
+#else
+    uint64_t ha = a >> 32, la = static_cast<uint32_t>(a);
+    uint64_t hb = b >> 32, lb = static_cast<uint32_t>(b);
+    uint64_t hh = ha * hb, hl = ha * lb, lh = la * hb, ll = la * lb;
+    uint64_t mid = (ll >> 32) + static_cast<uint32_t>(hl) + static_cast<uint32_t>(lh);
+    a = (mid << 32) | static_cast<uint32_t>(ll);
+    b = hh + (hl >> 32) + (lh >> 32) + (mid >> 32);
+#endif
+}
+
+static inline uint64_t wymix(uint64_t a, uint64_t b) {
+    wymum(a, b);
+    return a ^ b;
+}
+
+uint64_t HashFuncGen::wyhash64(std::string_view key, uint64_t seed) {
+    const uint64_t s0 = 0x2d358dccaa6c78a5ULL;
+    const uint64_t s1 = 0x8bb84b93962eacc9ULL;
+    const uint64_t s2 = 0x4b33a62ed433d4a3ULL;
+    const uint64_t s3 = 0x4d5a2da51de1aa47ULL;
+
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(key.data());
+    size_t len = key.size();
+    uint64_t a;
+    uint64_t b;
+    seed ^= wymix(seed ^ s0, s1);
+
+    if (len <= 16) {
+        if (len >= 4) {
+            a = (static_cast<uint64_t>(read32(p)) << 32) |
+                read32(p + ((len >> 3) << 2));
+            b = (static_cast<uint64_t>(read32(p + len - 4)) << 32) |
+                read32(p + len - 4 - ((len >> 3) << 2));
+        } else if (len > 0) {
+            a = (static_cast<uint64_t>(p[0]) << 16) |
+                (static_cast<uint64_t>(p[len >> 1]) << 8) | p[len - 1];
+            b = 0;
+        } else {
+            a = 0;
+            b = 0;
+        }
+    } else {
+        size_t i = len;
+        if (i > 48) {
+            uint64_t see1 = seed;
+            uint64_t see2 = seed;
+            do {
+                seed = wymix(read64(p) ^ s1, read64(p + 8) ^ seed);
+                see1 = wymix(read64(p + 16) ^ s2, read64(p + 24) ^ see1);
+                see2 = wymix(read64(p + 32) ^ s3, read64(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16) {
+            seed = wymix(read64(p) ^ s1, read64(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = read64(p + i - 16);
+        b = read64(p + i - 8);
+    }
+
+    a ^= s1;
+    b ^= seed;
+    wymum(a, b);
+    return wymix(a ^ s0 ^ static_cast<uint64_t>(len), b ^ s1);
+}
+
+uint32_t HashFuncGen::fnv1a_32(std::string_view key) {
     uint32_t hash = 2166136261u;
     for (char c : key) {
         hash ^= static_cast<uint8_t>(c);
         hash *= 16777619u;
     }
     return hash;
-}
\ No newline at end of file
+}
+
+uint64_t HashFuncGen::hash(HashKind kind, std::string_view key, uint32_t seed) {
+    switch (kind) {
+    case HashKind::Murmur3_128: {
+        uint64_t out[2];
+        murmur3_x64_128(key, seed, out);
+        return out[0];
+    }
+    case HashKind::XXH64:
+        return xxh64(key, seed);
+    case HashKind::WyHash64:
+        return wyhash64(key, seed);
+    case HashKind::Murmur3_32:
+    default:
+        return murmur3_32(key, seed);
+    }
+}
+
+void HashFuncGen::hashBatch(HashKind kind, const std::string_view* keys,
+                            size_t n, uint32_t seed, uint64_t* out) {
+    switch (kind) {
+    case HashKind::Murmur3_32: {
+        uint32_t hashes32[64];
+        for (size_t i = 0; i < n; i += 64) {
+            size_t len = std::min<size_t>(64, n - i);
+            murmur3_32_batch(keys + i, len, seed, hashes32);
+            for (size_t j = 0; j < len; ++j) {
+                out[i + j] = hashes32[j];
+            }
+        }
+        break;
+    }
+    case HashKind::XXH64:
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = xxh64(keys[i], seed);
+        }
+        break;
+    case HashKind::WyHash64:
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = wyhash64(keys[i], seed);
+        }
+        break;
+    default:
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = hash(kind, keys[i], seed);
+        }
+    }
+}
@@ -1,12 +1,40 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <string>
+#include <string_view>
+
+enum class HashKind : std::uint8_t {
+    Murmur3_32 = 0,
+    Murmur3_128 = 1,
+    XXH64 = 2,
+    WyHash64 = 3,
+};
 
 class HashFuncGen {
 public:
-    static uint32_t murmur3_32(const std::string& key,
+    static uint32_t murmur3_32(std::string_view key,
                                uint32_t seed = 0x9747b28c);
 
-    static uint32_t fnv1a_32(const std::string& key);
-};
\ No newline at end of file
+    static void murmur3_32_batch(const std::string_view* keys, size_t n,
+                                 uint32_t seed, uint32_t* out);
+
+    static void murmur3_x64_128(std::string_view key, uint32_t seed,
+                                uint64_t out[2]);
+
+    static uint64_t xxh64(std::string_view key, uint64_t seed = 0);
+
+    static uint64_t wyhash64(std::string_view key, uint64_t seed = 0);
+
+    static uint32_t fnv1a_32(std::string_view key);
+
+    static uint64_t hash(HashKind kind, std::string_view key, uint32_t seed);
+
+    static void hashBatch(HashKind kind, const std::string_view* keys, size_t n,
+                          uint32_t seed, uint64_t* out);
+
+    static int hashBits(HashKind kind) {
+        return kind == HashKind::Murmur3_32 ? 32 : 64;
+    }
+};
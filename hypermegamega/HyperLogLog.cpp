@@ -4,66 +4,348 @@
 #include <cstdint>
 #include <limits>
 #include <stdexcept>
-#include "HashFuncGen.hpp"
+#include <string>
 
-static int clz32(std::uint32_t x) {
+namespace {
+
+const std::uint8_t kMagic[3] = {'H', 'L', 'L'};
+const std::uint8_t kFormatVersion = 2;
+const std::size_t kHeaderSize = 12;
+
+enum Encoding : std::uint8_t {
+    kDense8 = 0,
+    kDense6 = 1,
+    kSparse = 2,
+};
+
+std::uint32_t entryIndex(std::uint32_t entry) {
+    return entry >> 6;
+}
+
+std::uint8_t entryRank(std::uint32_t entry) {
+    return static_cast<std::uint8_t>(entry & 0x3f);
+}
+
+// Merges two sorted entry lists, keeping the higher rank for a shared index.
+std::vector<std::uint32_t> mergeEntries(const std::vector<std::uint32_t>& x,
+                                        const std::vector<std::uint32_t>& y) {
+    std::vector<std::uint32_t> merged;
+    merged.reserve(x.size() + y.size());
+    auto a = x.begin();
+    auto b = y.begin();
+    while (a != x.end() || b != y.end()) {
+        if (b == y.end() || (a != x.end() && entryIndex(*a) < entryIndex(*b))) {
+            merged.push_back(*a++);
+        } else if (a == x.end() || entryIndex(*b) < entryIndex(*a)) {
+            merged.push_back(*b++);
+        } else {
+            merged.push_back(std::max(*a++, *b++));
+        }
+    }
+    return merged;
+}
+
+double sigma(double x) {
+    if (x == 1.0)
+        return std::numeric_limits<double>::infinity();
+    double y = 1.0;
+    double z = x;
+    double z_prev;
+    do {
+        x *= x;
+        z_prev = z;
+        z += x * y;
+        y += y;
+    } while (z != z_prev);
+    return z;
+}
+
+double tau(double x) {
+    if (x == 0.0 || x == 1.0)
+        return 0.0;
+    double y = 1.0;
+    double z = 1.0 - x;
+    double z_prev;
+    do {
+        x = std::sqrt(x);
+        z_prev = z;
+        y *= 0.5;
+        z -= (1.0 - x) * (1.0 - x) * y;
+    } while (z != z_prev);
+    return z / 3.0;
+}
+
+}
+
+static double alphaFor(std::size_t m) {
+    if (m == 16)
+        return 0.673;
+    if (m == 32)
+        return 0.697;
+    if (m == 64)
+        return 0.709;
+    return 0.7213 / (1.0 + 1.079 / static_cast<double>(m));
+}
+
+static int clz64(std::uint64_t x) {
     if (x == 0)
-        return 32;
+        return 64;
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_clzll(x);
+#else
     int r = 0;
-    while ((x & 0x80000000u) == 0u) {
+    while ((x & 0x8000000000000000ULL) == 0u) {
         ++r;
         x <<= 1;
     }
     return r;
+#endif
 }
 
-HyperLogLog::HyperLogLog(int b, std::uint32_t seed)
+HyperLogLog::HyperLogLog(int b, std::uint32_t seed, HashKind hash, bool sparse)
     : b_(b)
     , m_(1ULL << b)
-    , registers_(m_, 0)
-    , seed_(seed) {
-    if (b < 4 || b > 16) {
-        throw std::invalid_argument("b must be in [4, 16]");
+    , seed_(seed)
+    , hash_(hash)
+    , hash_bits_(HashFuncGen::hashBits(hash))
+    , start_sparse_(sparse)
+    , sparse_(sparse) {
+    if (b < 4 || b > maxPrecision(hash)) {
+        throw std::invalid_argument(hash_bits_ == 32 ? "b must be in [4, 16]"
+                                                     : "b must be in [4, 24]");
+    }
+    if (!sparse_) {
+        registers_.assign(m_, 0);
+        rebuildHistogram();
     }
+    alpha_ = alphaFor(m_);
+}
 
-    if (m_ == 16)
-        alpha_ = 0.673;
-    else if (m_ == 32)
-        alpha_ = 0.697;
-    else if (m_ == 64)
-        alpha_ = 0.709;
-    else
-        alpha_ = 0.7213 / (1.0 + 1.079 / static_cast<double>(m_));
+int HyperLogLog::maxPrecision(HashKind hash) {
+    return HashFuncGen::hashBits(hash) == 32 ? 16 : kMaxPrecision;
 }
 
-int HyperLogLog::rho(std::uint32_t hash, int b) {
-    std::uint32_t w = hash << b;
+void HyperLogLog::reduce(int b) {
+    if (b < 4 || b > b_) {
+        throw std::invalid_argument("b must be in [4, current precision]");
+    }
+    if (b == b_) {
+        return;
+    }
+
+    int d = b_ - b;
+    b_ = b;
+    m_ = 1ULL << b;
+    alpha_ = alphaFor(m_);
+    if (sparse_) {
+        flushSparse();
+        if (sparse_list_.size() > sparseLimit()) {
+            toDense();
+        }
+        return;
+    }
+
+    // The d low bits of an old index become the leading bits of the new rank
+    // window, exactly as if the sketch had been built at precision b.
+    std::vector<std::uint8_t> folded(m_, 0);
+    std::uint32_t low_mask = (1u << d) - 1;
+    for (std::size_t i = 0; i < registers_.size(); ++i) {
+        if (registers_[i] == 0)
+            continue;
+        std::uint32_t low = static_cast<std::uint32_t>(i) & low_mask;
+        int r = low != 0 ? rho(low, d) : d + registers_[i];
+        std::uint8_t& reg = folded[i >> d];
+        reg = std::max(reg, static_cast<std::uint8_t>(r));
+    }
+    registers_.swap(folded);
+    rebuildHistogram();
+}
+
+int HyperLogLog::rho(std::uint64_t w, int q) {
     if (w == 0)
-        return 32 - b + 1;
-    return clz32(w) + 1;
+        return q + 1;
+    return clz64(w) - (64 - q) + 1;
 }
 
-void HyperLogLog::add(const std::string& element) {
-    exact_set_.insert(element);
+void HyperLogLog::add(std::string_view element) {
+    addHash(HashFuncGen::hash(hash_, element, seed_));
+}
 
-    std::uint32_t hash = HashFuncGen::murmur3_32(element, seed_);
-    std::uint32_t index = hash >> (32 - b_);
-    int r = rho(hash, b_);
-    if (r > registers_[index]) {
-        registers_[index] = static_cast<std::uint8_t>(r);
+void HyperLogLog::addHash(std::uint64_t hash) {
+    if (sparse_) {
+        addSparse(hash);
+        return;
     }
+    int q = hash_bits_ - b_;
+    std::size_t index = static_cast<std::size_t>(hash >> q) & (m_ - 1);
+    int r = rho(hash & ((1ULL << q) - 1), q);
+    updateRegister(index, static_cast<std::uint8_t>(r));
 }
 
-double HyperLogLog::estimate() const {
-    double sum = 0.0;
-    int zero_registers = 0;
+void HyperLogLog::addBatch(const std::string_view* keys, std::size_t n) {
+    for (std::size_t i = 0; i < n; i += kBatchChunk) {
+        addChunk(keys + i, std::min(kBatchChunk, n - i));
+    }
+}
 
+void HyperLogLog::addBatch(const char* data, const std::uint32_t* offsets,
+                           std::size_t n) {
+    std::string_view keys[kBatchChunk];
+    for (std::size_t i = 0; i < n; i += kBatchChunk) {
+        std::size_t len = std::min(kBatchChunk, n - i);
+        for (std::size_t j = 0; j < len; ++j) {
+            keys[j] = std::string_view(data + offsets[i + j],
+                                       offsets[i + j + 1] - offsets[i + j]);
+        }
+        addChunk(keys, len);
+    }
+}
+
+void HyperLogLog::addChunk(const std::string_view* keys, std::size_t n) {
+    std::uint64_t hashes[kBatchChunk];
+    HashFuncGen::hashBatch(hash_, keys, n, seed_, hashes);
+
+    if (sparse_) {
+        for (std::size_t i = 0; i < n; ++i) {
+            addHash(hashes[i]);
+        }
+        return;
+    }
+
+    int q = hash_bits_ - b_;
+    std::uint64_t low_mask = (1ULL << q) - 1;
+    std::uint32_t indices[kBatchChunk];
+    std::uint8_t ranks[kBatchChunk];
+    for (std::size_t i = 0; i < n; ++i) {
+        indices[i] = static_cast<std::uint32_t>(hashes[i] >> q) &
+                     static_cast<std::uint32_t>(m_ - 1);
+        ranks[i] = static_cast<std::uint8_t>(rho(hashes[i] & low_mask, q));
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(&registers_[indices[i]], 1);
+#endif
+    }
+
+    for (std::size_t i = 0; i < n; ++i) {
+        updateRegister(indices[i], ranks[i]);
+    }
+}
+
+void HyperLogLog::addSparse(std::uint64_t hash) {
+    int q = hash_bits_ - kSparsePrecision;
+    std::uint32_t index = static_cast<std::uint32_t>(hash >> q) &
+                          ((1u << kSparsePrecision) - 1);
+    std::uint32_t entry = (index << 6) |
+                          static_cast<std::uint32_t>(rho(hash & ((1ULL << q) - 1), q));
+
+    sparse_buffer_.push_back(entry);
+    if (sparse_buffer_.size() >= kSparseBufferSize) {
+        flushSparse();
+        if (sparse_list_.size() > sparseLimit()) {
+            toDense();
+        }
+    }
+}
+
+void HyperLogLog::flushSparse() const {
+    if (sparse_buffer_.empty()) {
+        return;
+    }
+    // Sorting whole entries puts the highest rank last among equal indices.
+    std::sort(sparse_buffer_.begin(), sparse_buffer_.end());
+    std::size_t unique = 0;
+    for (std::size_t i = 0; i < sparse_buffer_.size(); ++i) {
+        if (unique > 0 &&
+            entryIndex(sparse_buffer_[unique - 1]) == entryIndex(sparse_buffer_[i])) {
+            sparse_buffer_[unique - 1] = sparse_buffer_[i];
+        } else {
+            sparse_buffer_[unique++] = sparse_buffer_[i];
+        }
+    }
+    sparse_buffer_.resize(unique);
+
+    sparse_list_ = mergeEntries(sparse_list_, sparse_buffer_);
+    sparse_buffer_.clear();
+}
+
+void HyperLogLog::mergeEntriesIntoDense(
+    const std::vector<std::uint32_t>& entries) {
+    int d = kSparsePrecision - b_;
+    std::uint32_t low_mask = (1u << d) - 1;
+    for (std::uint32_t entry : entries) {
+        std::uint32_t index = entryIndex(entry);
+        std::uint32_t low = index & low_mask;
+        int r = low != 0 ? rho(low, d) : d + entryRank(entry);
+        updateRegister(index >> d, static_cast<std::uint8_t>(r));
+    }
+}
+
+void HyperLogLog::toDense() {
+    flushSparse();
+    registers_.assign(m_, 0);
+    rebuildHistogram();
+    mergeEntriesIntoDense(sparse_list_);
+    sparse_list_.clear();
+    sparse_list_.shrink_to_fit();
+    sparse_buffer_.clear();
+    sparse_buffer_.shrink_to_fit();
+    sparse_ = false;
+}
+
+void HyperLogLog::mergeSparseList(const std::vector<std::uint32_t>& other) {
+    flushSparse();
+    sparse_list_ = mergeEntries(sparse_list_, other);
+    if (sparse_list_.size() > sparseLimit()) {
+        toDense();
+    }
+}
+
+void HyperLogLog::rebuildHistogram() {
+    histogram_.assign(static_cast<std::size_t>(hash_bits_ - b_ + 2), 0);
     for (std::uint8_t r : registers_) {
-        sum += 1.0 / static_cast<double>(1ULL << r);
-        if (r == 0)
-            ++zero_registers;
+        ++histogram_[r];
+    }
+}
+
+std::size_t HyperLogLog::memoryUsage() const {
+    return registers_.capacity() +
+           histogram_.capacity() * sizeof(std::uint32_t) +
+           (sparse_list_.capacity() + sparse_buffer_.capacity()) *
+               sizeof(std::uint32_t);
+}
+
+double HyperLogLog::estimate() const {
+    if (sparse_) {
+        flushSparse();
+        double m_sparse = static_cast<double>(1ULL << kSparsePrecision);
+        double zeros = m_sparse - static_cast<double>(sparse_list_.size());
+        return m_sparse * std::log(m_sparse / zeros);
+    }
+
+    return estimateFromHistogram(histogram_.data(), hash_bits_ - b_, m_);
+}
+
+double HyperLogLog::estimateFromHistogram(const std::uint32_t* histogram, int q,
+                                          std::size_t m_count) {
+    double m = static_cast<double>(m_count);
+    double z = m * tau(1.0 - static_cast<double>(histogram[q + 1]) / m);
+    for (int k = q; k >= 1; --k) {
+        z = 0.5 * (z + static_cast<double>(histogram[k]));
+    }
+    z += m * sigma(static_cast<double>(histogram[0]) / m);
+    return m * m / (2.0 * std::log(2.0) * z);
+}
+
+double HyperLogLog::estimateClassic() const {
+    if (sparse_) {
+        return estimate();
     }
 
+    double sum = 0.0;
+    for (std::size_t r = 0; r < histogram_.size(); ++r) {
+        sum += static_cast<double>(histogram_[r]) / static_cast<double>(1ULL << r);
+    }
+    std::uint32_t zero_registers = histogram_[0];
+
     double E = alpha_ * static_cast<double>(m_) * static_cast<double>(m_) / sum;
 
     if (E <= 2.5 * static_cast<double>(m_)) {
@@ -72,7 +354,7 @@ double HyperLogLog::estimate() const {
                 std::log(static_cast<double>(m_) /
                          static_cast<double>(zero_registers));
         }
-    } else if (E > static_cast<double>((1ULL << 32)) / 30.0) {
+    } else if (hash_bits_ == 32 && E > static_cast<double>((1ULL << 32)) / 30.0) {
         E = -static_cast<double>(1ULL << 32) *
             std::log(1.0 - E / static_cast<double>(1ULL << 32));
     }
@@ -81,6 +363,244 @@ double HyperLogLog::estimate() const {
 }
 
 void HyperLogLog::reset() {
-    std::fill(registers_.begin(), registers_.end(), 0);
-    exact_set_.clear();
+    if (start_sparse_) {
+        registers_.clear();
+        registers_.shrink_to_fit();
+        sparse_list_.clear();
+        sparse_buffer_.clear();
+        sparse_ = true;
+    } else {
+        std::fill(registers_.begin(), registers_.end(), 0);
+        rebuildHistogram();
+    }
+}
+
+void HyperLogLog::checkCompatible(const HyperLogLog& other) const {
+    if (seed_ != other.seed_ || hash_ != other.hash_) {
+        throw std::invalid_argument(
+            "sketches must share seed and hash to be merged");
+    }
+    if (!other.sparse_ && other.b_ < b_) {
+        throw std::invalid_argument(
+            "cannot merge a dense sketch of lower precision, reduce() this one first");
+    }
+}
+
+void HyperLogLog::merge(const HyperLogLog& other) {
+    checkCompatible(other);
+    if (sparse_ && other.sparse_) {
+        other.flushSparse();
+        mergeSparseList(other.sparse_list_);
+        return;
+    }
+    if (other.sparse_) {
+        other.flushSparse();
+        mergeEntriesIntoDense(other.sparse_list_);
+        return;
+    }
+    if (other.b_ > b_) {
+        HyperLogLog folded = other;
+        folded.reduce(b_);
+        mergeRegisters(folded.registers_.data(), folded.m_);
+        return;
+    }
+    mergeRegisters(other.registers_.data(), other.m_);
+}
+
+void HyperLogLog::mergeRegisters(const std::uint8_t* registers,
+                                 std::size_t count) {
+    if (count != m_) {
+        throw std::invalid_argument("register count does not match 2^b");
+    }
+    std::uint8_t max_rank = static_cast<std::uint8_t>(hash_bits_ - b_ + 1);
+    for (std::size_t i = 0; i < m_; ++i) {
+        if (registers[i] > max_rank) {
+            throw std::invalid_argument("HyperLogLog register out of range");
+        }
+    }
+    if (sparse_) {
+        toDense();
+    }
+    for (std::size_t i = 0; i < m_; ++i) {
+        updateRegister(i, registers[i]);
+    }
+}
+
+std::vector<std::uint8_t> HyperLogLog::denseRegisters() const {
+    if (!sparse_) {
+        return registers_;
+    }
+    HyperLogLog dense = *this;
+    dense.toDense();
+    return dense.registers_;
+}
+
+double HyperLogLog::unionEstimate(const HyperLogLog& a, const HyperLogLog& b) {
+    const bool a_coarser = a.b_ <= b.b_;
+    HyperLogLog u = a_coarser ? a : b;
+    u.merge(a_coarser ? b : a);
+    return u.estimate();
+}
+
+double HyperLogLog::intersectionEstimate(const HyperLogLog& a,
+                                         const HyperLogLog& b) {
+    double inter = a.estimate() + b.estimate() - unionEstimate(a, b);
+    return std::max(0.0, inter);
+}
+
+std::vector<std::uint8_t> HyperLogLog::serialize() const {
+    std::vector<std::uint8_t> out(kHeaderSize, 0);
+    out[0] = kMagic[0];
+    out[1] = kMagic[1];
+    out[2] = kMagic[2];
+    out[3] = kFormatVersion;
+    out[4] = static_cast<std::uint8_t>(b_);
+    out[5] = static_cast<std::uint8_t>(hash_);
+    out[6] = sparse_ ? kSparse : kDense6;
+    out[7] = start_sparse_ ? 1 : 0;
+    for (int i = 0; i < 4; ++i) {
+        out[8 + i] = static_cast<std::uint8_t>(seed_ >> (8 * i));
+    }
+
+    if (sparse_) {
+        flushSparse();
+        std::uint32_t count = static_cast<std::uint32_t>(sparse_list_.size());
+        for (int i = 0; i < 4; ++i) {
+            out.push_back(static_cast<std::uint8_t>(count >> (8 * i)));
+        }
+        std::uint32_t prev = 0;
+        for (std::uint32_t entry : sparse_list_) {
+            std::uint32_t delta = entry - prev;
+            prev = entry;
+            while (delta >= 0x80) {
+                out.push_back(static_cast<std::uint8_t>(delta | 0x80));
+                delta >>= 7;
+            }
+            out.push_back(static_cast<std::uint8_t>(delta));
+        }
+        return out;
+    }
+
+    out.resize(kHeaderSize + m_ * 6 / 8, 0);
+    std::uint8_t* payload = out.data() + kHeaderSize;
+    for (std::size_t i = 0; i < m_; ++i) {
+        std::size_t bit = i * 6;
+        std::uint32_t v = static_cast<std::uint32_t>(registers_[i]) << (bit % 8);
+        payload[bit / 8] |= static_cast<std::uint8_t>(v);
+        if (v >> 8)
+            payload[bit / 8 + 1] |= static_cast<std::uint8_t>(v >> 8);
+    }
+    return out;
+}
+
+HyperLogLog HyperLogLog::deserialize(const std::uint8_t* data,
+                                     std::size_t size) {
+    if (size < kHeaderSize) {
+        throw std::invalid_argument("truncated HyperLogLog header");
+    }
+    if (data[0] != kMagic[0] || data[1] != kMagic[1] || data[2] != kMagic[2]) {
+        throw std::invalid_argument("not a serialized HyperLogLog");
+    }
+    if (data[3] != kFormatVersion) {
+        throw std::invalid_argument(
+            "HyperLogLog format version " + std::to_string(data[3]) +
+            ", expected " + std::to_string(kFormatVersion));
+    }
+
+    int b = data[4];
+    if (data[5] > static_cast<std::uint8_t>(HashKind::WyHash64)) {
+        throw std::invalid_argument("unknown hash kind");
+    }
+    std::uint32_t seed = 0;
+    for (int i = 0; i < 4; ++i) {
+        seed |= static_cast<std::uint32_t>(data[8 + i]) << (8 * i);
+    }
+
+    HyperLogLog h(b, seed, static_cast<HashKind>(data[5]), data[6] == kSparse);
+    h.start_sparse_ = data[7] != 0;
+    const std::uint8_t* payload = data + kHeaderSize;
+    std::size_t payload_size = size - kHeaderSize;
+    std::uint8_t max_rank = static_cast<std::uint8_t>(h.hash_bits_ - b + 1);
+
+    if (data[6] == kSparse) {
+        std::uint8_t max_sparse_rank =
+            static_cast<std::uint8_t>(h.hash_bits_ - kSparsePrecision + 1);
+        if (payload_size < 4) {
+            throw std::invalid_argument("truncated sparse HyperLogLog");
+        }
+        std::uint32_t count = 0;
+        for (int i = 0; i < 4; ++i) {
+            count |= static_cast<std::uint32_t>(payload[i]) << (8 * i);
+        }
+        // Every entry takes at least one byte, so a larger count is truncated
+        // input rather than a reason to reserve memory.
+        if (count > payload_size - 4) {
+            throw std::invalid_argument("truncated sparse HyperLogLog");
+        }
+        h.sparse_list_.reserve(count);
+        std::uint32_t prev = 0;
+        std::size_t pos = 4;
+        for (std::uint32_t n = 0; n < count; ++n) {
+            std::uint32_t delta = 0;
+            int shift = 0;
+            std::uint8_t byte;
+            do {
+                if (pos >= payload_size) {
+                    throw std::invalid_argument("truncated sparse HyperLogLog");
+                }
+                if (shift > 28) {
+                    throw std::invalid_argument("malformed sparse HyperLogLog");
+                }
+                byte = payload[pos++];
+                delta |= static_cast<std::uint32_t>(byte & 0x7f) << shift;
+                shift += 7;
+            } while (byte & 0x80);
+
+            std::uint32_t entry = prev + delta;
+            if ((!h.sparse_list_.empty() && entryIndex(entry) <= entryIndex(prev)) ||
+                entryIndex(entry) >= (1u << kSparsePrecision) ||
+                entryRank(entry) == 0 || entryRank(entry) > max_sparse_rank) {
+                throw std::invalid_argument("malformed sparse HyperLogLog");
+            }
+            h.sparse_list_.push_back(entry);
+            prev = entry;
+        }
+        if (pos != payload_size) {
+            throw std::invalid_argument("trailing bytes after sparse HyperLogLog");
+        }
+        // serialize() flushes the pending buffer without converting, so a list
+        // may exceed sparseLimit() by up to one buffer; it is kept as is so
+        // that the round trip is exact. Anything longer did not come from
+        // serialize() and is converted rather than held as a huge list.
+        if (h.sparse_list_.size() > h.sparseLimit() + kSparseBufferSize) {
+            h.toDense();
+        }
+        return h;
+    } else if (data[6] == kDense8) {
+        if (payload_size != h.m_) {
+            throw std::invalid_argument("truncated HyperLogLog registers");
+        }
+        std::copy(payload, payload + h.m_, h.registers_.begin());
+    } else if (data[6] == kDense6) {
+        if (payload_size != h.m_ * 6 / 8) {
+            throw std::invalid_argument("truncated HyperLogLog registers");
+        }
+        for (std::size_t i = 0; i < h.m_; ++i) {
+            std::size_t bit = i * 6;
+            std::uint32_t v = payload[bit / 8];
+            if (bit % 8 > 2)
+                v |= static_cast<std::uint32_t>(payload[bit / 8 + 1]) << 8;
+            h.registers_[i] = static_cast<std::uint8_t>((v >> (bit % 8)) & 0x3f);
+        }
+    } else {
+        throw std::invalid_argument("unknown HyperLogLog encoding");
+    }
+
+    for (std::uint8_t r : h.registers_) {
+        if (r > max_rank) {
+            throw std::invalid_argument("HyperLogLog register out of range");
+        }
+    }
+    h.rebuildHistogram();
+    return h;
 }
@@ -4,30 +4,126 @@
 #include <cmath>
 #include <cstdint>
 #include <string>
-#include <unordered_set>
+#include <string_view>
 #include <vector>
+#include "HashFuncGen.hpp"
 
 class HyperLogLog {
 public:
-    explicit HyperLogLog(int b, std::uint32_t seed = 0x9747b28c);
+    explicit HyperLogLog(int b, std::uint32_t seed = 0x9747b28c,
+                         HashKind hash = HashKind::Murmur3_32,
+                         bool sparse = false);
 
-    void add(const std::string& element);
+    void add(std::string_view element);
+
+    void addHash(std::uint64_t hash);
+
+    void addBatch(const std::string_view* keys, std::size_t n);
+
+    void addBatch(const char* data, const std::uint32_t* offsets, std::size_t n);
 
     double estimate() const;
 
-    size_t exactCount() const {
-        return exact_set_.size();
-    }
+    double estimateClassic() const;
 
     void reset();
 
+    void merge(const HyperLogLog& other);
+
+    void reduce(int b);
+
+    static double unionEstimate(const HyperLogLog& a, const HyperLogLog& b);
+
+    static double intersectionEstimate(const HyperLogLog& a,
+                                       const HyperLogLog& b);
+
+    std::vector<std::uint8_t> serialize() const;
+
+    static HyperLogLog deserialize(const std::uint8_t* data, std::size_t size);
+
+    int precision() const {
+        return b_;
+    }
+
+    std::uint32_t seed() const {
+        return seed_;
+    }
+
+    HashKind hashKind() const {
+        return hash_;
+    }
+
+    bool isSparse() const {
+        return sparse_;
+    }
+
+    std::size_t memoryUsage() const;
+
+    void mergeRegisters(const std::uint8_t* registers, std::size_t count);
+
+    std::vector<std::uint8_t> denseRegisters() const;
+
+    static int rho(std::uint64_t w, int q);
+
+    static double estimateFromHistogram(const std::uint32_t* histogram, int q,
+                                        std::size_t m);
+
+    static int maxPrecision(HashKind hash);
+
+    static constexpr int kSparsePrecision = 25;
+
+    static constexpr int kMaxPrecision = 24;
+
 private:
     int b_;
     std::size_t m_;
     std::vector<std::uint8_t> registers_;
+    std::vector<std::uint32_t> histogram_;
     mutable double alpha_;
     std::uint32_t seed_;
-    std::unordered_set<std::string> exact_set_;
+    HashKind hash_;
+    int hash_bits_;
+    bool start_sparse_;
+    bool sparse_;
+    // Sorted, one entry per index. New entries collect unsorted in
+    // sparse_buffer_ and are merged in when it fills or before a read, so an
+    // insert is amortized O(list / buffer) instead of O(list).
+    mutable std::vector<std::uint32_t> sparse_list_;
+    mutable std::vector<std::uint32_t> sparse_buffer_;
+
+    static constexpr std::size_t kBatchChunk = 64;
+
+    static constexpr std::size_t kSparseBufferSize = 1024;
+
+    // Longest sparse list before switching to dense registers, whatever m is.
+    static constexpr std::size_t kMaxSparseEntries = 1 << 14;
+
+    void addChunk(const std::string_view* keys, std::size_t n);
+
+    void checkCompatible(const HyperLogLog& other) const;
+
+    void addSparse(std::uint64_t hash);
+
+    void flushSparse() const;
+
+    std::size_t sparseLimit() const {
+        return std::min(m_ / sizeof(std::uint32_t), kMaxSparseEntries);
+    }
+
+    void mergeSparseList(const std::vector<std::uint32_t>& other);
+
+    void toDense();
+
+    void updateRegister(std::size_t index, std::uint8_t rank) {
+        std::uint8_t& reg = registers_[index];
+        if (rank > reg) {
+            --histogram_[reg];
+            ++histogram_[rank];
+            reg = rank;
+        }
+    }
+
+    void rebuildHistogram();
 
-    static int rho(std::uint32_t hash, int b);
+    void mergeEntriesIntoDense(const std::vector<std::uint32_t>& entries);
 };
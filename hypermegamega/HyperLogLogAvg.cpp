@@ -1,26 +1,37 @@
 #include "HyperLogLogAvg.hpp"
 #include <cstdint>
+#include <stdexcept>
 
-static std::uint32_t mix_seed(std::uint32_t x) {
-    x ^= x >> 16;
-    x *= 0x7feb352du;
-    x ^= x >> 15;
-    x *= 0x846ca68bu;
-    x ^= x >> 16;
+static std::uint64_t mix64(std::uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
     return x;
 }
 
-HyperLogLogAvg::HyperLogLogAvg(int b, std::size_t k, std::uint32_t base_seed) {
+HyperLogLogAvg::HyperLogLogAvg(int b, std::size_t k, std::uint32_t base_seed,
+                               HashKind hash)
+    : seed_(base_seed)
+    , hash_(hash) {
+    if (HashFuncGen::hashBits(hash) != 64) {
+        throw std::invalid_argument("HyperLogLogAvg needs a 64-bit hash");
+    }
+    salts_.reserve(k);
     sketches_.reserve(k);
     for (std::size_t i = 0; i < k; ++i) {
-        std::uint32_t s = mix_seed(base_seed + static_cast<std::uint32_t>(i * 0x9e3779b9u));
-        sketches_.emplace_back(b, s);
+        std::uint64_t s = mix64(base_seed + (i + 1) * 0x9e3779b97f4a7c15ULL);
+        salts_.push_back(s);
+        sketches_.emplace_back(b, static_cast<std::uint32_t>(s), hash);
     }
 }
 
-void HyperLogLogAvg::add(const std::string& element) {
-    for (auto& h : sketches_) {
-        h.add(element);
+// Every sketch gets a bijective remix of the same 64-bit hash.
+void HyperLogLogAvg::add(std::string_view element) {
+    std::uint64_t hash = HashFuncGen::hash(hash_, element, seed_);
+    for (std::size_t i = 0; i < sketches_.size(); ++i) {
+        sketches_[i].addHash(mix64(hash ^ salts_[i]));
     }
 }
 
@@ -32,12 +43,6 @@ double HyperLogLogAvg::estimateMean() const {
     return sum / static_cast<double>(sketches_.size());
 }
 
-std::size_t HyperLogLogAvg::exactCount() const {
-    if (sketches_.empty())
-        return 0;
-    return sketches_[0].exactCount();
-}
-
 void HyperLogLogAvg::reset() {
     for (auto& h : sketches_) {
         h.reset();
@@ -1,22 +1,26 @@
 #pragma once
 
 #include <cstdint>
-#include <string>
+#include <string_view>
 #include <vector>
 #include "HyperLogLog.hpp"
 
+// k sketches fed from one 64-bit hash per element; the hash must be a 64-bit
+// kind, since keys colliding in a 32-bit base would collide in every sketch.
 class HyperLogLogAvg {
 public:
-    HyperLogLogAvg(int b, std::size_t k, std::uint32_t base_seed = 0x9747b28c);
+    HyperLogLogAvg(int b, std::size_t k, std::uint32_t base_seed = 0x9747b28c,
+                   HashKind hash = HashKind::WyHash64);
 
-    void add(const std::string& element);
+    void add(std::string_view element);
 
     double estimateMean() const;
 
-    std::size_t exactCount() const;
-
     void reset();
 
 private:
+    std::uint32_t seed_;
+    HashKind hash_;
+    std::vector<std::uint64_t> salts_;
     std::vector<HyperLogLog> sketches_;
 };
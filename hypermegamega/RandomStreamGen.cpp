@@ -1,21 +1,272 @@
 #include "RandomStreamGen.hpp"
 #include <algorithm>
+#include <cmath>
+#include <fstream>
 #include <iterator>
+#include <stdexcept>
 
-RandomStreamGen::RandomStreamGen(unsigned int seed)
-    : rng_(seed) {
+static std::uint64_t splitmix64(std::uint64_t& x) {
+    std::uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
 }
 
-std::string RandomStreamGen::generateElement() {
-    static std::uniform_int_distribution<size_t> len_dist(1, 30);
-    size_t len = len_dist(rng_);
+static std::uint32_t bounded(std::uint32_t r, std::uint32_t n) {
+    return static_cast<std::uint32_t>((static_cast<std::uint64_t>(r) * n) >> 32);
+}
+
+Xoshiro256::Xoshiro256(std::uint64_t seed) {
+    for (auto& s : s_) {
+        s = splitmix64(seed);
+    }
+}
+
+RandomStreamGen::RandomStreamGen(unsigned int seed, Engine engine)
+    : seed_(seed)
+    , engine_(engine)
+    , rng_(seed)
+    , fast_rng_(seed)
+    , len_dist_(1, kMaxLength)
+    , char_dist_(0, charset_.size() - 1)
+    , buf_(kMaxLength) {
+}
+
+void RandomStreamGen::setProfile(const Profile& profile) {
+    if (profile.min_length == 0 || profile.min_length > profile.max_length) {
+        throw std::invalid_argument("lengths must satisfy 0 < min_length <= max_length");
+    }
+    if (profile.lengths == LengthDistribution::Geometric &&
+        !(profile.mean_length >= static_cast<double>(profile.min_length))) {
+        throw std::invalid_argument("mean_length must be at least min_length");
+    }
+
+    const bool keyed = profile.keys == KeyDistribution::Uniform ||
+                       profile.keys == KeyDistribution::Zipf;
+    std::size_t digits = 0;
+    if (keyed) {
+        if (profile.universe == 0) {
+            throw std::invalid_argument("universe must be positive");
+        }
+        if (profile.keys == KeyDistribution::Zipf && !(profile.zipf_exponent > 0.0)) {
+            throw std::invalid_argument("zipf_exponent must be positive");
+        }
+        digits = 1;
+        for (std::uint64_t v = (profile.universe - 1) / charset_.size(); v > 0;
+             v /= charset_.size()) {
+            ++digits;
+        }
+        if (digits > profile.max_length) {
+            throw std::invalid_argument("max_length is too short for universe distinct keys");
+        }
+    }
+    if (profile.keys == KeyDistribution::Replay && !replay_) {
+        throw std::invalid_argument("no keys loaded for replay");
+    }
+
+    profile_ = profile;
+    id_digits_ = digits;
+    len_dist_ = std::uniform_int_distribution<size_t>(profile.min_length, profile.max_length);
+    geom_log_q_ = std::log1p(-1.0 / (profile.mean_length - profile.min_length + 1.0));
+
+    if (profile.keys == KeyDistribution::Zipf) {
+        const double s = profile.zipf_exponent;
+        zipf_h_x1_ = zipfH(1.5) - 1.0;
+        zipf_h_n_ = zipfH(static_cast<double>(profile.universe) + 0.5);
+        zipf_s_ = 2.0 - zipfHInverse(zipfH(2.5) - std::exp(-s * std::log(2.0)));
+    }
+
+    if (profile.keys == KeyDistribution::Replay) {
+        const std::vector<std::uint32_t>& offsets = replay_->offsets;
+        std::size_t longest = 1;
+        for (std::size_t i = 0; i + 1 < offsets.size(); ++i) {
+            longest = std::max<std::size_t>(longest, offsets[i + 1] - offsets[i]);
+        }
+        buf_.resize(longest);
+    } else {
+        buf_.resize(profile.max_length);
+    }
+}
+
+std::shared_ptr<const RandomStreamGen::KeySet> RandomStreamGen::readKeys(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::invalid_argument("cannot open key file " + path);
+    }
+    std::vector<char> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    auto keys = std::make_shared<KeySet>();
+    keys->offsets.assign(1, 0);
+    std::size_t begin = 0;
+    for (std::size_t i = 0; i <= data.size(); ++i) {
+        if (i < data.size() && data[i] != '\n') {
+            continue;
+        }
+        std::size_t end = i;
+        if (end > begin && data[end - 1] == '\r') {
+            --end;
+        }
+        if (end > begin) {
+            keys->data.insert(keys->data.end(), data.begin() + begin, data.begin() + end);
+            if (keys->data.size() > UINT32_MAX) {
+                throw std::invalid_argument("key file " + path + " is larger than 4 GiB");
+            }
+            keys->offsets.push_back(static_cast<std::uint32_t>(keys->data.size()));
+        }
+        begin = i + 1;
+    }
+    if (keys->offsets.size() < 2) {
+        throw std::invalid_argument("key file " + path + " contains no keys");
+    }
+    return keys;
+}
+
+// Generators share one KeySet; each starts at an offset drawn from its own
+// seed, so streams with different seeds do not replay the same sequence.
+void RandomStreamGen::setKeys(std::shared_ptr<const KeySet> keys) {
+    if (!keys || keys->offsets.size() < 2) {
+        throw std::invalid_argument("no keys to replay");
+    }
+    std::uint64_t x = seed_;
+    replay_ = std::move(keys);
+    replay_pos_ = splitmix64(x) % (replay_->offsets.size() - 1);
+
+    Profile profile = profile_;
+    profile.keys = KeyDistribution::Replay;
+    setProfile(profile);
+}
+
+void RandomStreamGen::loadKeys(const std::string& path) {
+    setKeys(readKeys(path));
+}
+
+std::uint64_t RandomStreamGen::draw() {
+    if (engine_ == Engine::Mt19937) {
+        std::uint64_t hi = rng_();
+        return (hi << 32) | rng_();
+    }
+    return fast_rng_();
+}
 
-    std::string element(len, ' ');
-    std::uniform_int_distribution<size_t> char_dist(0, charset_.size() - 1);
-    for (size_t i = 0; i < len; ++i) {
-        element[i] = charset_[char_dist(rng_)];
+double RandomStreamGen::drawUnit() {
+    return static_cast<double>(draw() >> 11) * 0x1.0p-53;
+}
+
+std::size_t RandomStreamGen::drawLength(std::uint64_t r) const {
+    const std::uint32_t r32 = static_cast<std::uint32_t>(r);
+    if (profile_.lengths == LengthDistribution::Uniform) {
+        const std::uint32_t span =
+            static_cast<std::uint32_t>(profile_.max_length - profile_.min_length + 1);
+        return profile_.min_length + bounded(r32, span);
+    }
+    const double u = (static_cast<double>(r32) + 0.5) * 0x1.0p-32;
+    const double extra = std::floor(std::log(u) / geom_log_q_);
+    if (extra >= static_cast<double>(profile_.max_length - profile_.min_length)) {
+        return profile_.max_length;
+    }
+    return profile_.min_length + static_cast<std::size_t>(extra);
+}
+
+// Rejection-inversion sampling (W. Hormann, G. Derflinger, 1996): O(1) per
+// draw for any exponent and universe size, no tables.
+double RandomStreamGen::zipfH(double x) const {
+    const double log_x = std::log(x);
+    const double t = (1.0 - profile_.zipf_exponent) * log_x;
+    const double ratio = std::abs(t) > 1e-8 ? std::expm1(t) / t : 1.0 + t / 2.0;
+    return ratio * log_x;
+}
+
+double RandomStreamGen::zipfHInverse(double x) const {
+    // Rounding can push t just below -1, where log1p is NaN.
+    const double t = std::max(x * (1.0 - profile_.zipf_exponent), -1.0);
+    const double ratio = std::abs(t) > 1e-8 ? std::log1p(t) / t : 1.0 - t / 2.0;
+    return std::exp(ratio * x);
+}
+
+std::uint64_t RandomStreamGen::drawZipf() {
+    const double n = static_cast<double>(profile_.universe);
+    while (true) {
+        const double u = zipf_h_n_ + drawUnit() * (zipf_h_x1_ - zipf_h_n_);
+        const double x = zipfHInverse(u);
+        const double k = std::min(std::max(std::floor(x + 0.5), 1.0), n);
+        if (k - x <= zipf_s_ ||
+            u >= zipfH(k + 0.5) - std::exp(-profile_.zipf_exponent * std::log(k))) {
+            return static_cast<std::uint64_t>(k) - 1;
+        }
+    }
+}
+
+std::size_t RandomStreamGen::fillKey(std::uint64_t id, char* out) {
+    Xoshiro256 key_rng(profile_.key_seed ^ (id * 0x9e3779b97f4a7c15ULL));
+    const std::uint32_t charset_size = static_cast<std::uint32_t>(charset_.size());
+    std::uint64_t r = key_rng();
+    const size_t len = std::max(drawLength(r), id_digits_);
+    const size_t filler = len - id_digits_;
+    for (size_t i = 0; i < filler; i += 2) {
+        r = key_rng();
+        out[i] = charset_[bounded(static_cast<std::uint32_t>(r), charset_size)];
+        if (i + 1 < filler)
+            out[i + 1] = charset_[bounded(static_cast<std::uint32_t>(r >> 32), charset_size)];
+    }
+    for (size_t i = len; i > filler; --i) {
+        out[i - 1] = charset_[id % charset_size];
+        id /= charset_size;
+    }
+    return len;
+}
+
+std::size_t RandomStreamGen::fillUnique(char* out) {
+    if (engine_ == Engine::Mt19937) {
+        size_t len = profile_.lengths == LengthDistribution::Uniform ? len_dist_(rng_)
+                                                                     : drawLength(rng_());
+        for (size_t i = 0; i < len; ++i) {
+            out[i] = charset_[char_dist_(rng_)];
+        }
+        return len;
     }
-    return element;
+
+    const std::uint32_t charset_size = static_cast<std::uint32_t>(charset_.size());
+    std::uint64_t r = fast_rng_();
+    size_t len = drawLength(r);
+    out[0] = charset_[bounded(static_cast<std::uint32_t>(r >> 32), charset_size)];
+    for (size_t i = 1; i < len; i += 2) {
+        r = fast_rng_();
+        out[i] = charset_[bounded(static_cast<std::uint32_t>(r), charset_size)];
+        if (i + 1 < len)
+            out[i + 1] = charset_[bounded(static_cast<std::uint32_t>(r >> 32), charset_size)];
+    }
+    return len;
+}
+
+std::size_t RandomStreamGen::fill(char* out) {
+    switch (profile_.keys) {
+    case KeyDistribution::Uniform: {
+        const std::uint64_t id = static_cast<std::uint64_t>(
+            drawUnit() * static_cast<double>(profile_.universe));
+        return fillKey(std::min(id, profile_.universe - 1), out);
+    }
+    case KeyDistribution::Zipf:
+        return fillKey(drawZipf(), out);
+    case KeyDistribution::Replay: {
+        const std::uint32_t begin = replay_->offsets[replay_pos_];
+        const std::uint32_t end = replay_->offsets[replay_pos_ + 1];
+        std::copy(replay_->data.begin() + begin, replay_->data.begin() + end, out);
+        if (++replay_pos_ + 1 == replay_->offsets.size()) {
+            replay_pos_ = 0;
+        }
+        return end - begin;
+    }
+    default:
+        return fillUnique(out);
+    }
+}
+
+std::string RandomStreamGen::generateElement() {
+    return std::string(next());
+}
+
+std::string_view RandomStreamGen::next() {
+    return std::string_view(buf_.data(), fill(buf_.data()));
 }
 
 std::vector<std::string> RandomStreamGen::generateStream(size_t n) {
@@ -25,4 +276,21 @@ std::vector<std::string> RandomStreamGen::generateStream(size_t n) {
         stream.push_back(generateElement());
     }
     return stream;
-}
\ No newline at end of file
+}
+
+void RandomStreamGen::generateInto(std::size_t n, std::vector<char>& data,
+                                   std::vector<std::uint32_t>& offsets) {
+    if (n > UINT32_MAX / maxLength()) {
+        throw std::invalid_argument("block too large for 32-bit offsets, generate it in parts");
+    }
+    data.clear();
+    data.reserve(n * maxLength());
+    offsets.clear();
+    offsets.reserve(n + 1);
+    offsets.push_back(0);
+    for (std::size_t i = 0; i < n; ++i) {
+        const std::size_t len = fill(buf_.data());
+        data.insert(data.end(), buf_.data(), buf_.data() + len);
+        offsets.push_back(static_cast<std::uint32_t>(data.size()));
+    }
+}
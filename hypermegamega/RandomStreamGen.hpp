@@ -1,19 +1,148 @@
 #pragma once
 
+#include <cstdint>
+#include <memory>
 #include <random>
 #include <string>
+#include <string_view>
 #include <vector>
 
+class Xoshiro256 {
+public:
+    using result_type = std::uint64_t;
+
+    explicit Xoshiro256(std::uint64_t seed);
+
+    static constexpr result_type min() {
+        return 0;
+    }
+
+    static constexpr result_type max() {
+        return ~static_cast<result_type>(0);
+    }
+
+    result_type operator()() {
+        const std::uint64_t result = rotl(s_[1] * 5, 7) * 9;
+        const std::uint64_t t = s_[1] << 17;
+        s_[2] ^= s_[0];
+        s_[3] ^= s_[1];
+        s_[1] ^= s_[2];
+        s_[0] ^= s_[3];
+        s_[2] ^= t;
+        s_[3] = rotl(s_[3], 45);
+        return result;
+    }
+
+private:
+    std::uint64_t s_[4];
+
+    static std::uint64_t rotl(std::uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+};
+
 class RandomStreamGen {
 public:
-    RandomStreamGen(unsigned int seed = std::random_device{}());
+    enum class Engine {
+        Mt19937,
+        Xoshiro256,
+    };
+
+    enum class KeyDistribution {
+        Unique,
+        Uniform,
+        Zipf,
+        Replay,
+    };
+
+    enum class LengthDistribution {
+        Uniform,
+        Geometric,
+    };
+
+    static constexpr std::size_t kMaxLength = 30;
+
+    struct Profile {
+        KeyDistribution keys = KeyDistribution::Unique;
+        std::uint64_t universe = 1000000;
+        std::uint64_t key_seed = 0;
+        double zipf_exponent = 1.0;
+        LengthDistribution lengths = LengthDistribution::Uniform;
+        std::size_t min_length = 1;
+        std::size_t max_length = kMaxLength;
+        double mean_length = 8.0;
+    };
+
+    // Keys for KeyDistribution::Replay, packed like generateInto output.
+    struct KeySet {
+        std::vector<char> data;
+        std::vector<std::uint32_t> offsets;
+    };
+
+    RandomStreamGen(unsigned int seed = std::random_device{}(),
+                    Engine engine = Engine::Mt19937);
+
+    void setProfile(const Profile& profile);
+
+    static std::shared_ptr<const KeySet> readKeys(const std::string& path);
+
+    void setKeys(std::shared_ptr<const KeySet> keys);
+
+    void loadKeys(const std::string& path);
+
+    const Profile& profile() const {
+        return profile_;
+    }
+
+    std::size_t maxLength() const {
+        return buf_.size();
+    }
 
     std::string generateElement();
 
     std::vector<std::string> generateStream(size_t n);
 
+    std::string_view next();
+
+    void generateInto(std::size_t n, std::vector<char>& data,
+                      std::vector<std::uint32_t>& offsets);
+
 private:
-    std::mt19937 rng_;
     const std::string charset_ =
         "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789-";
-};
\ No newline at end of file
+    unsigned int seed_;
+    Engine engine_;
+    std::mt19937 rng_;
+    Xoshiro256 fast_rng_;
+    std::uniform_int_distribution<size_t> len_dist_;
+    std::uniform_int_distribution<size_t> char_dist_;
+    std::vector<char> buf_;
+
+    Profile profile_;
+    std::size_t id_digits_ = 0;
+    double zipf_h_x1_ = 0.0;
+    double zipf_h_n_ = 0.0;
+    double zipf_s_ = 0.0;
+    double geom_log_q_ = 0.0;
+
+    std::shared_ptr<const KeySet> replay_;
+    std::size_t replay_pos_ = 0;
+
+    std::size_t fill(char* out);
+
+    std::size_t fillUnique(char* out);
+
+    std::size_t fillKey(std::uint64_t id, char* out);
+
+    std::uint64_t draw();
+
+    double drawUnit();
+
+    std::size_t drawLength(std::uint64_t r) const;
+
+    std::uint64_t drawZipf();
+
+    double zipfH(double x) const;
+
+    double zipfHInverse(double x) const;
+};
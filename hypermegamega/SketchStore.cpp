@@ -0,0 +1,413 @@
+#include "SketchStore.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char kStoreMagic[4] = {'H', 'L', 'L', 'S'};
+const std::uint32_t kStoreVersion = 1;
+const std::size_t kStoreHeaderSize = 64;
+const std::size_t kKeySlotSize = SketchStore::kMaxKeyLength + 1;
+const std::size_t kBlockAlign = 64;
+
+struct Layout {
+    std::size_t index_size;
+    std::size_t keys_offset;
+    std::size_t registers_offset;
+    std::size_t total;
+};
+
+Layout layoutFor(std::size_t capacity, std::size_t m) {
+    Layout layout;
+    layout.index_size = 1;
+    while (layout.index_size < capacity * 2) {
+        layout.index_size <<= 1;
+    }
+    layout.keys_offset = kStoreHeaderSize + layout.index_size * sizeof(std::uint32_t);
+    std::size_t keys_end = layout.keys_offset + capacity * kKeySlotSize;
+    layout.registers_offset = (keys_end + kBlockAlign - 1) / kBlockAlign * kBlockAlign;
+    layout.total = layout.registers_offset + capacity * m;
+    return layout;
+}
+
+std::uint64_t keyHash(std::string_view key) {
+    return HashFuncGen::xxh64(key);
+}
+
+[[noreturn]] void throwErrno(const std::string& what) {
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+}
+
+struct SketchStore::Header {
+    char magic[4];
+    std::uint32_t version;
+    std::uint8_t b;
+    std::uint8_t hash;
+    std::uint8_t reserved[2];
+    std::uint32_t seed;
+    std::uint64_t capacity;
+    std::uint64_t size;
+    std::uint64_t index_size;
+};
+
+SketchView::SketchView(std::uint8_t* registers, int b, std::uint32_t seed,
+                       HashKind hash)
+    : registers_(registers)
+    , b_(b)
+    , m_(1ULL << b)
+    , seed_(seed)
+    , hash_(hash)
+    , hash_bits_(HashFuncGen::hashBits(hash)) {
+}
+
+void SketchView::add(std::string_view element) {
+    addHash(HashFuncGen::hash(hash_, element, seed_));
+}
+
+void SketchView::addHash(std::uint64_t hash) {
+    int q = hash_bits_ - b_;
+    std::size_t index = static_cast<std::size_t>(hash >> q) & (m_ - 1);
+    std::uint8_t r = static_cast<std::uint8_t>(HyperLogLog::rho(hash & ((1ULL << q) - 1), q));
+    if (r > registers_[index])
+        registers_[index] = r;
+}
+
+double SketchView::estimate() const {
+    int q = hash_bits_ - b_;
+    // The registers live in a shared mapping that another process may have
+    // written since open() checked them, so an out-of-range byte is clamped
+    // rather than trusted as a histogram index.
+    std::uint8_t max_rank = static_cast<std::uint8_t>(q + 1);
+    std::uint32_t histogram[66] = {};
+    for (std::size_t i = 0; i < m_; ++i) {
+        ++histogram[std::min(registers_[i], max_rank)];
+    }
+    return HyperLogLog::estimateFromHistogram(histogram, q, m_);
+}
+
+void SketchView::mergeRegisters(const std::uint8_t* registers) {
+    for (std::size_t i = 0; i < m_; ++i) {
+        registers_[i] = std::max(registers_[i], registers[i]);
+    }
+}
+
+void SketchView::merge(const SketchView& other) {
+    if (b_ != other.b_ || seed_ != other.seed_ || hash_ != other.hash_) {
+        throw std::invalid_argument("sketches must share b, seed and hash to be merged");
+    }
+    mergeRegisters(other.registers_);
+}
+
+void SketchView::merge(const HyperLogLog& other) {
+    if (b_ > other.precision() || seed_ != other.seed() || hash_ != other.hashKind()) {
+        throw std::invalid_argument("sketches must share seed and hash and be at least as precise");
+    }
+    if (other.precision() == b_) {
+        mergeRegisters(other.denseRegisters().data());
+        return;
+    }
+    HyperLogLog folded = other;
+    folded.reduce(b_);
+    mergeRegisters(folded.denseRegisters().data());
+}
+
+void SketchView::reset() {
+    std::fill(registers_, registers_ + m_, 0);
+}
+
+HyperLogLog SketchView::toHyperLogLog() const {
+    HyperLogLog hll(b_, seed_, hash_);
+    hll.mergeRegisters(registers_, m_);
+    return hll;
+}
+
+SketchStore::SketchStore(int fd, std::uint8_t* base, std::size_t mapped_size)
+    : fd_(fd)
+    , base_(base)
+    , mapped_size_(mapped_size) {
+}
+
+SketchStore::SketchStore(SketchStore&& other) noexcept
+    : fd_(other.fd_)
+    , base_(other.base_)
+    , mapped_size_(other.mapped_size_)
+    , keys_offset_(other.keys_offset_)
+    , registers_offset_(other.registers_offset_) {
+    other.fd_ = -1;
+    other.base_ = nullptr;
+    other.mapped_size_ = 0;
+}
+
+SketchStore& SketchStore::operator=(SketchStore&& other) noexcept {
+    if (this != &other) {
+        close();
+        fd_ = other.fd_;
+        base_ = other.base_;
+        mapped_size_ = other.mapped_size_;
+        keys_offset_ = other.keys_offset_;
+        registers_offset_ = other.registers_offset_;
+        other.fd_ = -1;
+        other.base_ = nullptr;
+        other.mapped_size_ = 0;
+    }
+    return *this;
+}
+
+SketchStore::~SketchStore() {
+    close();
+}
+
+void SketchStore::close() {
+    if (base_ != nullptr)
+        ::munmap(base_, mapped_size_);
+    if (fd_ >= 0)
+        ::close(fd_);
+    base_ = nullptr;
+    fd_ = -1;
+}
+
+SketchStore SketchStore::create(const std::string& path, int b, std::size_t capacity,
+                                std::uint32_t seed, HashKind hash) {
+    if (b < 4 || b > HyperLogLog::maxPrecision(hash)) {
+        throw std::invalid_argument(HashFuncGen::hashBits(hash) == 32 ? "b must be in [4, 16]"
+                                                                      : "b must be in [4, 24]");
+    }
+    static_assert(sizeof(Header) <= kStoreHeaderSize, "store header does not fit");
+    capacity = std::max<std::size_t>(capacity, 1);
+    Layout layout = layoutFor(capacity, 1ULL << b);
+
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        throwErrno("cannot create " + path);
+    SketchStore store(fd, nullptr, 0);
+    store.remap(layout.total);
+
+    Header& h = store.header();
+    std::memcpy(h.magic, kStoreMagic, sizeof(kStoreMagic));
+    h.version = kStoreVersion;
+    h.b = static_cast<std::uint8_t>(b);
+    h.hash = static_cast<std::uint8_t>(hash);
+    h.seed = seed;
+    h.capacity = capacity;
+    h.size = 0;
+    h.index_size = layout.index_size;
+    store.refreshLayout();
+    return store;
+}
+
+SketchStore SketchStore::open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDWR);
+    if (fd < 0)
+        throwErrno("cannot open " + path);
+    SketchStore store(fd, nullptr, 0);
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0)
+        throwErrno("cannot stat " + path);
+    if (static_cast<std::size_t>(st.st_size) < kStoreHeaderSize) {
+        throw std::invalid_argument(path + " is not a sketch store");
+    }
+    store.remap(static_cast<std::size_t>(st.st_size));
+
+    const Header& h = store.header();
+    if (std::memcmp(h.magic, kStoreMagic, sizeof(kStoreMagic)) != 0) {
+        throw std::invalid_argument(path + " is not a sketch store");
+    }
+    if (h.version != kStoreVersion) {
+        throw std::invalid_argument("unsupported sketch store version");
+    }
+    if (h.hash > static_cast<std::uint8_t>(HashKind::WyHash64) || h.b < 4 ||
+        h.b > HyperLogLog::maxPrecision(static_cast<HashKind>(h.hash)) ||
+        h.size > h.capacity ||
+        layoutFor(h.capacity, 1ULL << h.b).total != store.mapped_size_ ||
+        layoutFor(h.capacity, 1ULL << h.b).index_size != h.index_size) {
+        throw std::invalid_argument(path + " has a corrupt header");
+    }
+    store.refreshLayout();
+
+    const std::uint8_t max_rank = static_cast<std::uint8_t>(
+        HashFuncGen::hashBits(static_cast<HashKind>(h.hash)) - h.b + 1);
+    const std::uint8_t* registers = store.registerBlock(0);
+    const std::uint8_t* end = store.registerBlock(h.size);
+    if (std::any_of(registers, end, [max_rank](std::uint8_t r) { return r > max_rank; })) {
+        throw std::invalid_argument(path + " has registers out of range");
+    }
+    return store;
+}
+
+void SketchStore::remap(std::size_t new_size) {
+    if (base_ != nullptr) {
+        ::munmap(base_, mapped_size_);
+        base_ = nullptr;
+        mapped_size_ = 0;
+    }
+    struct stat st;
+    if (::fstat(fd_, &st) != 0)
+        throwErrno("cannot stat sketch store");
+    if (static_cast<std::size_t>(st.st_size) < new_size &&
+        ::ftruncate(fd_, static_cast<off_t>(new_size)) != 0)
+        throwErrno("cannot resize sketch store");
+    void* p = ::mmap(nullptr, new_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (p == MAP_FAILED)
+        throwErrno("cannot map sketch store");
+    base_ = static_cast<std::uint8_t*>(p);
+    mapped_size_ = new_size;
+}
+
+void SketchStore::refreshLayout() {
+    const Header& h = header();
+    Layout layout = layoutFor(h.capacity, 1ULL << h.b);
+    keys_offset_ = layout.keys_offset;
+    registers_offset_ = layout.registers_offset;
+}
+
+SketchStore::Header& SketchStore::header() const {
+    return *reinterpret_cast<Header*>(base_);
+}
+
+std::uint32_t* SketchStore::index() const {
+    return reinterpret_cast<std::uint32_t*>(base_ + kStoreHeaderSize);
+}
+
+std::uint8_t* SketchStore::keySlot(std::size_t slot) const {
+    return base_ + keys_offset_ + slot * kKeySlotSize;
+}
+
+std::uint8_t* SketchStore::registerBlock(std::size_t slot) const {
+    return base_ + registers_offset_ + (slot << header().b);
+}
+
+std::size_t SketchStore::lookup(std::string_view key, std::uint64_t hash) const {
+    const std::uint32_t* table = index();
+    std::size_t mask = header().index_size - 1;
+    for (std::size_t pos = hash & mask;; pos = (pos + 1) & mask) {
+        std::uint32_t entry = table[pos];
+        if (entry == 0)
+            return pos;
+        const std::uint8_t* slot = keySlot(entry - 1);
+        if (slot[0] == key.size() && std::memcmp(slot + 1, key.data(), key.size()) == 0)
+            return pos;
+    }
+}
+
+void SketchStore::insertIndex(std::uint64_t hash, std::size_t slot) {
+    std::uint32_t* table = index();
+    std::size_t mask = header().index_size - 1;
+    std::size_t pos = hash & mask;
+    while (table[pos] != 0) {
+        pos = (pos + 1) & mask;
+    }
+    table[pos] = static_cast<std::uint32_t>(slot + 1);
+}
+
+SketchView SketchStore::get(std::string_view key) {
+    if (key.size() > kMaxKeyLength) {
+        throw std::invalid_argument("sketch key is longer than 63 bytes");
+    }
+    std::uint64_t hash = keyHash(key);
+    std::size_t pos = lookup(key, hash);
+    if (index()[pos] != 0)
+        return at(index()[pos] - 1);
+
+    if (header().size == header().capacity) {
+        reserve(header().capacity * 2);
+        pos = lookup(key, hash);
+    }
+    Header& h = header();
+    std::size_t slot = h.size;
+    std::uint8_t* key_slot = keySlot(slot);
+    key_slot[0] = static_cast<std::uint8_t>(key.size());
+    std::memcpy(key_slot + 1, key.data(), key.size());
+    std::fill(registerBlock(slot), registerBlock(slot) + (1ULL << h.b), 0);
+    index()[pos] = static_cast<std::uint32_t>(slot + 1);
+    h.size = slot + 1;
+    return at(slot);
+}
+
+std::optional<SketchView> SketchStore::find(std::string_view key) {
+    if (key.size() > kMaxKeyLength)
+        return std::nullopt;
+    std::uint32_t entry = index()[lookup(key, keyHash(key))];
+    if (entry == 0)
+        return std::nullopt;
+    return at(entry - 1);
+}
+
+SketchView SketchStore::at(std::size_t slot) {
+    const Header& h = header();
+    if (slot >= h.size) {
+        throw std::out_of_range("sketch slot out of range");
+    }
+    return SketchView(registerBlock(slot), h.b, h.seed, static_cast<HashKind>(h.hash));
+}
+
+std::string_view SketchStore::key(std::size_t slot) const {
+    if (slot >= header().size) {
+        throw std::out_of_range("sketch slot out of range");
+    }
+    const std::uint8_t* key_slot = keySlot(slot);
+    return std::string_view(reinterpret_cast<const char*>(key_slot + 1), key_slot[0]);
+}
+
+void SketchStore::reserve(std::size_t capacity) {
+    const Header& h = header();
+    if (capacity <= h.capacity)
+        return;
+    std::size_t m = 1ULL << h.b;
+    std::size_t old_capacity = h.capacity;
+    std::size_t used = h.size;
+    Layout old_layout = layoutFor(old_capacity, m);
+    Layout new_layout = layoutFor(capacity, m);
+
+    remap(new_layout.total);
+    // Regions only move towards the end of the file, so shifting the last one
+    // first never overwrites data that is still to be moved. Blocks of the new
+    // slots lie past the old end of file and are already zero.
+    std::memmove(base_ + new_layout.registers_offset, base_ + old_layout.registers_offset,
+                 old_capacity * m);
+    std::memmove(base_ + new_layout.keys_offset, base_ + old_layout.keys_offset,
+                 used * kKeySlotSize);
+
+    Header& nh = header();
+    nh.capacity = capacity;
+    nh.index_size = new_layout.index_size;
+    refreshLayout();
+    std::memset(index(), 0, new_layout.index_size * sizeof(std::uint32_t));
+    for (std::size_t slot = 0; slot < used; ++slot) {
+        insertIndex(keyHash(key(slot)), slot);
+    }
+}
+
+void SketchStore::sync() {
+    if (::msync(base_, mapped_size_, MS_SYNC) != 0)
+        throwErrno("cannot sync sketch store");
+}
+
+std::size_t SketchStore::size() const {
+    return header().size;
+}
+
+std::size_t SketchStore::capacity() const {
+    return header().capacity;
+}
+
+int SketchStore::precision() const {
+    return header().b;
+}
+
+HashKind SketchStore::hashKind() const {
+    return static_cast<HashKind>(header().hash);
+}
+
+std::uint32_t SketchStore::seed() const {
+    return header().seed;
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include "HashFuncGen.hpp"
+#include "HyperLogLog.hpp"
+
+// A view of one sketch's registers inside the store's mapping. Growing the
+// store (get() of a new key at full capacity, or reserve()) remaps the file
+// and invalidates every view obtained before, like std::vector iterators;
+// reserve() up front or call get()/at() again after growing.
+class SketchView {
+public:
+    void add(std::string_view element);
+
+    void addHash(std::uint64_t hash);
+
+    double estimate() const;
+
+    void merge(const SketchView& other);
+
+    void merge(const HyperLogLog& other);
+
+    void reset();
+
+    HyperLogLog toHyperLogLog() const;
+
+    const std::uint8_t* registers() const {
+        return registers_;
+    }
+
+    std::size_t size() const {
+        return m_;
+    }
+
+private:
+    friend class SketchStore;
+
+    SketchView(std::uint8_t* registers, int b, std::uint32_t seed, HashKind hash);
+
+    std::uint8_t* registers_;
+    int b_;
+    std::size_t m_;
+    std::uint32_t seed_;
+    HashKind hash_;
+    int hash_bits_;
+
+    void mergeRegisters(const std::uint8_t* registers);
+};
+
+class SketchStore {
+public:
+    static constexpr std::size_t kMaxKeyLength = 63;
+
+    static SketchStore create(const std::string& path, int b, std::size_t capacity,
+                              std::uint32_t seed = 0x9747b28c,
+                              HashKind hash = HashKind::Murmur3_32);
+
+    static SketchStore open(const std::string& path);
+
+    SketchStore(SketchStore&& other) noexcept;
+
+    SketchStore& operator=(SketchStore&& other) noexcept;
+
+    SketchStore(const SketchStore&) = delete;
+
+    SketchStore& operator=(const SketchStore&) = delete;
+
+    ~SketchStore();
+
+    SketchView get(std::string_view key);
+
+    std::optional<SketchView> find(std::string_view key);
+
+    SketchView at(std::size_t slot);
+
+    std::string_view key(std::size_t slot) const;
+
+    void reserve(std::size_t capacity);
+
+    void sync();
+
+    std::size_t size() const;
+
+    std::size_t capacity() const;
+
+    int precision() const;
+
+    HashKind hashKind() const;
+
+    std::uint32_t seed() const;
+
+private:
+    struct Header;
+
+    int fd_ = -1;
+    std::uint8_t* base_ = nullptr;
+    std::size_t mapped_size_ = 0;
+    std::size_t keys_offset_ = 0;
+    std::size_t registers_offset_ = 0;
+
+    SketchStore(int fd, std::uint8_t* base, std::size_t mapped_size);
+
+    Header& header() const;
+
+    std::uint32_t* index() const;
+
+    std::uint8_t* keySlot(std::size_t slot) const;
+
+    std::uint8_t* registerBlock(std::size_t slot) const;
+
+    std::size_t lookup(std::string_view key, std::uint64_t hash) const;
+
+    void insertIndex(std::uint64_t hash, std::size_t slot);
+
+    void remap(std::size_t new_size);
+
+    void refreshLayout();
+
+    void close();
+};
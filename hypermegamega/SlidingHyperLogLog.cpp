@@ -0,0 +1,78 @@
+#include "SlidingHyperLogLog.hpp"
+#include <stdexcept>
+
+SlidingHyperLogLog::SlidingHyperLogLog(int b, std::uint64_t max_window,
+                                       std::size_t slices, std::uint32_t seed,
+                                       HashKind hash)
+    : b_(b)
+    , seed_(seed)
+    , hash_(hash)
+    , slice_width_(slices == 0 ? 0 : (max_window + slices - 1) / slices)
+    , epochs_(slices + 1, 0)
+    , latest_epoch_(0) {
+    if (slices == 0 || max_window == 0) {
+        throw std::invalid_argument("max_window and slices must be positive");
+    }
+    slices_.reserve(slices + 1);
+    for (std::size_t i = 0; i <= slices; ++i) {
+        slices_.emplace_back(b, seed, hash, true);
+    }
+}
+
+HyperLogLog* SlidingHyperLogLog::sliceFor(std::uint64_t timestamp) {
+    std::uint64_t epoch = timestamp / slice_width_ + 1;
+    if (epoch + slices_.size() <= latest_epoch_) {
+        return nullptr;
+    }
+    latest_epoch_ = std::max(latest_epoch_, epoch);
+
+    std::size_t slot = static_cast<std::size_t>(epoch % slices_.size());
+    if (epochs_[slot] != epoch) {
+        slices_[slot].reset();
+        epochs_[slot] = epoch;
+    }
+    return &slices_[slot];
+}
+
+void SlidingHyperLogLog::add(std::string_view element,
+                             std::uint64_t timestamp) {
+    addHash(HashFuncGen::hash(hash_, element, seed_), timestamp);
+}
+
+void SlidingHyperLogLog::addHash(std::uint64_t hash, std::uint64_t timestamp) {
+    HyperLogLog* slice = sliceFor(timestamp);
+    if (slice != nullptr) {
+        slice->addHash(hash);
+    }
+}
+
+HyperLogLog SlidingHyperLogLog::window(std::uint64_t now,
+                                       std::uint64_t length) const {
+    if (length > slice_width_ * (slices_.size() - 1)) {
+        throw std::invalid_argument("window is longer than max_window");
+    }
+
+    HyperLogLog result(b_, seed_, hash_, true);
+    if (length == 0) {
+        return result;
+    }
+    // The window holds timestamps (now - length, now]; merge the slices
+    // covering its first and last timestamp and everything in between.
+    std::uint64_t first = (length > now ? 0 : (now - length + 1) / slice_width_) + 1;
+    std::uint64_t last = now / slice_width_ + 1;
+    for (std::uint64_t epoch = first; epoch <= last; ++epoch) {
+        std::size_t slot = static_cast<std::size_t>(epoch % slices_.size());
+        if (epochs_[slot] == epoch) {
+            result.merge(slices_[slot]);
+        }
+    }
+    return result;
+}
+
+void SlidingHyperLogLog::reset() {
+    for (auto& s : slices_) {
+        s.reset();
+    }
+    std::fill(epochs_.begin(), epochs_.end(), 0);
+    latest_epoch_ = 0;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "HashFuncGen.hpp"
+#include "HyperLogLog.hpp"
+
+class SlidingHyperLogLog {
+public:
+    SlidingHyperLogLog(int b, std::uint64_t max_window, std::size_t slices,
+                       std::uint32_t seed = 0x9747b28c,
+                       HashKind hash = HashKind::Murmur3_32);
+
+    void add(std::string_view element, std::uint64_t timestamp);
+
+    void addHash(std::uint64_t hash, std::uint64_t timestamp);
+
+    HyperLogLog window(std::uint64_t now, std::uint64_t length) const;
+
+    double estimate(std::uint64_t now, std::uint64_t length) const {
+        return window(now, length).estimate();
+    }
+
+    std::uint64_t sliceWidth() const {
+        return slice_width_;
+    }
+
+    void reset();
+
+private:
+    int b_;
+    std::uint32_t seed_;
+    HashKind hash_;
+    std::uint64_t slice_width_;
+    std::vector<HyperLogLog> slices_;
+    std::vector<std::uint64_t> epochs_;
+    std::uint64_t latest_epoch_;
+
+    HyperLogLog* sliceFor(std::uint64_t timestamp);
+};
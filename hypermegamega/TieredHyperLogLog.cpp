@@ -0,0 +1,48 @@
+#include "TieredHyperLogLog.hpp"
+#include <stdexcept>
+#include <utility>
+
+TieredHyperLogLog::TieredHyperLogLog(int max_b, std::size_t memory_budget,
+                                     std::uint32_t seed, HashKind hash)
+    : max_b_(max_b)
+    , memory_budget_(memory_budget)
+    , sketch_(precisionFor(memory_budget, max_b, hash), seed, hash, true) {
+}
+
+int TieredHyperLogLog::precisionFor(std::size_t memory_budget, int max_b,
+                                    HashKind hash) {
+    if (max_b < 4 || max_b > HyperLogLog::maxPrecision(hash)) {
+        throw std::invalid_argument("max_b is out of range for this hash");
+    }
+    int hash_bits = HashFuncGen::hashBits(hash);
+    int b = max_b;
+    while (b > 4) {
+        std::size_t dense_bytes = (std::size_t{1} << b) +
+                                  static_cast<std::size_t>(hash_bits - b + 2) * sizeof(std::uint32_t);
+        if (dense_bytes <= memory_budget)
+            break;
+        --b;
+    }
+    return b;
+}
+
+void TieredHyperLogLog::setMemoryBudget(std::size_t memory_budget) {
+    int b = precisionFor(memory_budget, max_b_, sketch_.hashKind());
+    memory_budget_ = memory_budget;
+    if (b < sketch_.precision()) {
+        sketch_.reduce(b);
+    } else if (b > sketch_.precision() && sketch_.isSparse()) {
+        // Sparse entries keep kSparsePrecision index bits, so nothing is lost
+        // by moving them to a finer dense target.
+        HyperLogLog upgraded(b, sketch_.seed(), sketch_.hashKind(), true);
+        upgraded.merge(sketch_);
+        sketch_ = std::move(upgraded);
+    }
+}
+
+void TieredHyperLogLog::merge(const HyperLogLog& other) {
+    if (!other.isSparse() && other.precision() < sketch_.precision()) {
+        sketch_.reduce(other.precision());
+    }
+    sketch_.merge(other);
+}
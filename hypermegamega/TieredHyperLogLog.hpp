@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include "HashFuncGen.hpp"
+#include "HyperLogLog.hpp"
+
+class TieredHyperLogLog {
+public:
+    TieredHyperLogLog(int max_b, std::size_t memory_budget,
+                      std::uint32_t seed = 0x9747b28c,
+                      HashKind hash = HashKind::WyHash64);
+
+    void add(std::string_view element) {
+        sketch_.add(element);
+    }
+
+    void addHash(std::uint64_t hash) {
+        sketch_.addHash(hash);
+    }
+
+    void addBatch(const std::string_view* keys, std::size_t n) {
+        sketch_.addBatch(keys, n);
+    }
+
+    double estimate() const {
+        return sketch_.estimate();
+    }
+
+    void merge(const HyperLogLog& other);
+
+    void merge(const TieredHyperLogLog& other) {
+        merge(other.sketch_);
+    }
+
+    void setMemoryBudget(std::size_t memory_budget);
+
+    std::size_t memoryBudget() const {
+        return memory_budget_;
+    }
+
+    int precision() const {
+        return sketch_.precision();
+    }
+
+    int maxPrecision() const {
+        return max_b_;
+    }
+
+    const HyperLogLog& sketch() const {
+        return sketch_;
+    }
+
+    static int precisionFor(std::size_t memory_budget, int max_b, HashKind hash);
+
+private:
+    int max_b_;
+    std::size_t memory_budget_;
+    HyperLogLog sketch_;
+};
@@ -0,0 +1,429 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "ConcurrentHyperLogLog.hpp"
+#include "HashFuncGen.hpp"
+#include "HyperLogLog.hpp"
+#include "HyperLogLogAvg.hpp"
+#include "RandomStreamGen.hpp"
+#include "TieredHyperLogLog.hpp"
+
+static constexpr std::size_t kKeys = 1 << 12;
+static constexpr std::size_t kStream = 1 << 16;
+
+struct BenchOptions {
+    double min_time = 0.2;
+    int repetitions = 3;
+    std::string filter;
+    std::string csv_path;
+    std::string json_path;
+    std::string baseline_path;
+};
+
+struct BenchResult {
+    std::string name;
+    std::uint64_t iterations = 0;
+    double ns_per_op = 0.0;
+    double items_per_sec = 0.0;
+    double bytes_per_sec = 0.0;
+};
+
+// Body runs `iterations` operations and returns the number of key bytes it touched.
+using BenchBody = std::function<std::uint64_t(std::uint64_t iterations)>;
+
+template <class T>
+static inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static BenchResult runBench(const std::string& name, const BenchBody& body,
+                            const BenchOptions& options) {
+    std::uint64_t iterations = 1024;
+    while (true) {
+        auto start = std::chrono::steady_clock::now();
+        body(iterations);
+        double elapsed = secondsSince(start);
+        if (elapsed >= options.min_time / 10 || iterations >= (1ULL << 40)) {
+            double scale = options.min_time / std::max(elapsed, 1e-9);
+            iterations = std::max<std::uint64_t>(
+                1, static_cast<std::uint64_t>(static_cast<double>(iterations) * scale));
+            break;
+        }
+        iterations *= 10;
+    }
+
+    std::vector<double> seconds;
+    std::uint64_t bytes = 0;
+    for (int r = 0; r < options.repetitions; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        bytes = body(iterations);
+        seconds.push_back(secondsSince(start));
+    }
+    std::sort(seconds.begin(), seconds.end());
+    double median = seconds[seconds.size() / 2];
+
+    BenchResult result;
+    result.name = name;
+    result.iterations = iterations;
+    result.ns_per_op = median * 1e9 / static_cast<double>(iterations);
+    result.items_per_sec = static_cast<double>(iterations) / median;
+    result.bytes_per_sec = static_cast<double>(bytes) / median;
+    return result;
+}
+
+static std::vector<std::string> fixedLengthKeys(std::size_t count, std::size_t len) {
+    RandomStreamGen gen(7, RandomStreamGen::Engine::Xoshiro256);
+    RandomStreamGen::Profile profile;
+    profile.min_length = len;
+    profile.max_length = len;
+    gen.setProfile(profile);
+    std::vector<std::string> keys;
+    keys.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        keys.push_back(gen.generateElement());
+    }
+    return keys;
+}
+
+struct PackedKeys {
+    std::vector<char> data;
+    std::vector<std::uint32_t> offsets;
+    std::vector<std::string_view> views;
+};
+
+static PackedKeys streamKeys(std::size_t count) {
+    RandomStreamGen gen(11, RandomStreamGen::Engine::Xoshiro256);
+    PackedKeys keys;
+    gen.generateInto(count, keys.data, keys.offsets);
+    keys.views.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        keys.views.emplace_back(keys.data.data() + keys.offsets[i],
+                                keys.offsets[i + 1] - keys.offsets[i]);
+    }
+    return keys;
+}
+
+// Distinct 64-bit hashes for the fill benchmarks, which need more keys than
+// the packed stream holds.
+static std::uint64_t splitmix64(std::uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// Adds n hashes, starting a fresh sketch from make() every `fill` adds, so
+// the whole run stays in the regime of a sketch holding up to `fill` keys.
+template <class Sketch, class Make>
+static BenchBody fillBench(std::uint64_t fill, Make make) {
+    return [fill, make](std::uint64_t n) {
+        std::uint64_t i = 0;
+        while (i < n) {
+            Sketch sketch = make();
+            std::uint64_t end = std::min(n, i + fill);
+            for (; i < end; ++i) {
+                sketch.addHash(splitmix64(i));
+            }
+            double e = sketch.estimate();
+            doNotOptimize(e);
+        }
+        return std::uint64_t{0};
+    };
+}
+
+static std::vector<std::pair<std::string, BenchBody>> registerBenchmarks() {
+    std::vector<std::pair<std::string, BenchBody>> benches;
+
+    for (std::size_t len : {4, 8, 16, 32, 64, 256, 1024}) {
+        auto keys = std::make_shared<std::vector<std::string>>(fixedLengthKeys(kKeys, len));
+        const std::string suffix = "/len:" + std::to_string(len);
+
+        benches.emplace_back("murmur3_32" + suffix, [keys, len](std::uint64_t n) {
+            std::uint32_t acc = 0;
+            for (std::uint64_t i = 0; i < n; ++i) {
+                acc += HashFuncGen::murmur3_32((*keys)[i & (kKeys - 1)]);
+            }
+            doNotOptimize(acc);
+            return n * len;
+        });
+        benches.emplace_back("fnv1a_32" + suffix, [keys, len](std::uint64_t n) {
+            std::uint32_t acc = 0;
+            for (std::uint64_t i = 0; i < n; ++i) {
+                acc += HashFuncGen::fnv1a_32((*keys)[i & (kKeys - 1)]);
+            }
+            doNotOptimize(acc);
+            return n * len;
+        });
+        benches.emplace_back("xxh64" + suffix, [keys, len](std::uint64_t n) {
+            std::uint64_t acc = 0;
+            for (std::uint64_t i = 0; i < n; ++i) {
+                acc += HashFuncGen::xxh64((*keys)[i & (kKeys - 1)]);
+            }
+            doNotOptimize(acc);
+            return n * len;
+        });
+        benches.emplace_back("wyhash64" + suffix, [keys, len](std::uint64_t n) {
+            std::uint64_t acc = 0;
+            for (std::uint64_t i = 0; i < n; ++i) {
+                acc += HashFuncGen::wyhash64((*keys)[i & (kKeys - 1)]);
+            }
+            doNotOptimize(acc);
+            return n * len;
+        });
+    }
+
+    auto stream = std::make_shared<PackedKeys>(streamKeys(kStream));
+    const std::uint64_t stream_bytes = stream->data.size();
+
+    for (int b = 4; b <= 16; ++b) {
+        auto hll = std::make_shared<HyperLogLog>(b);
+        benches.emplace_back("hll_add/b:" + std::to_string(b), [hll, stream](std::uint64_t n) {
+            std::uint64_t bytes = 0;
+            for (std::uint64_t i = 0; i < n; ++i) {
+                std::string_view key = stream->views[i & (kStream - 1)];
+                hll->add(key);
+                bytes += key.size();
+            }
+            return bytes;
+        });
+    }
+
+    for (int b : {4, 8, 12, 16}) {
+        auto hll = std::make_shared<HyperLogLog>(b);
+        benches.emplace_back("hll_add_batch/b:" + std::to_string(b),
+                             [hll, stream, stream_bytes](std::uint64_t n) {
+            std::uint64_t done = 0;
+            std::uint64_t bytes = 0;
+            while (done < n) {
+                std::size_t chunk = static_cast<std::size_t>(std::min<std::uint64_t>(n - done, kStream));
+                hll->addBatch(stream->data.data(), stream->offsets.data(), chunk);
+                bytes += chunk == kStream ? stream_bytes : stream->offsets[chunk];
+                done += chunk;
+            }
+            return bytes;
+        });
+    }
+
+    for (int b : {4, 8, 12, 16}) {
+        auto hll = std::make_shared<HyperLogLog>(b);
+        hll->addBatch(stream->data.data(), stream->offsets.data(), kStream);
+        benches.emplace_back("hll_estimate/b:" + std::to_string(b), [hll](std::uint64_t n) {
+            double acc = 0.0;
+            for (std::uint64_t i = 0; i < n; ++i) {
+                acc += hll->estimate();
+                doNotOptimize(acc);
+            }
+            return std::uint64_t{0};
+        });
+    }
+
+    // Up to the sparse-to-dense switch point: m/4 adds into a new sketch.
+    for (int b : {14, 18, 22}) {
+        std::uint64_t fill = (std::uint64_t{1} << b) / 4;
+        for (bool sparse : {false, true}) {
+            benches.emplace_back(
+                std::string(sparse ? "hll_fill_sparse/b:" : "hll_fill_dense/b:") +
+                    std::to_string(b),
+                fillBench<HyperLogLog>(fill, [b, sparse] {
+                    return HyperLogLog(b, 0x9747b28c, HashKind::WyHash64, sparse);
+                }));
+        }
+    }
+
+    for (int max_b : {18, 22}) {
+        std::uint64_t fill = (std::uint64_t{1} << max_b) / 4;
+        std::size_t budget = std::size_t{1} << (max_b + 1);
+        benches.emplace_back("tiered_fill/max_b:" + std::to_string(max_b),
+                             fillBench<TieredHyperLogLog>(fill, [max_b, budget] {
+                                 return TieredHyperLogLog(max_b, budget);
+                             }));
+    }
+
+    // Shared registers (shards:1) against one shard per thread, for 1, 2, 4, ...
+    // threads up to the number of cores. n distinct hashes are split between
+    // the threads, and ns/op is wall time per add across all of them.
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned> thread_counts;
+    for (unsigned t = 1; t < cores; t *= 2) {
+        thread_counts.push_back(t);
+    }
+    thread_counts.push_back(cores);
+    for (int b : {12, 16}) {
+        for (unsigned threads : thread_counts) {
+            std::vector<std::size_t> shard_counts = {1};
+            if (threads > 1) {
+                shard_counts.push_back(threads);
+            }
+            for (std::size_t shards : shard_counts) {
+                auto hll = std::make_shared<ConcurrentHyperLogLog>(
+                    b, 0x9747b28c, HashKind::WyHash64, shards);
+                auto next = std::make_shared<std::uint64_t>(0);
+                benches.emplace_back(
+                    "concurrent_add/b:" + std::to_string(b) + "/shards:" +
+                        std::to_string(shards) + "/threads:" + std::to_string(threads),
+                    [hll, next, threads](std::uint64_t n) {
+                        std::uint64_t base = *next;
+                        *next += n;
+                        auto worker = [&](unsigned t) {
+                            std::uint64_t end = base + n * (t + 1) / threads;
+                            for (std::uint64_t i = base + n * t / threads; i < end; ++i) {
+                                hll->addHash(splitmix64(i));
+                            }
+                        };
+                        std::vector<std::thread> pool;
+                        for (unsigned t = 1; t < threads; ++t) {
+                            pool.emplace_back(worker, t);
+                        }
+                        worker(0);
+                        for (auto& t : pool) {
+                            t.join();
+                        }
+                        return std::uint64_t{0};
+                    });
+            }
+        }
+    }
+
+    for (std::size_t k : {1, 2, 4, 8, 16, 32}) {
+        auto avg = std::make_shared<HyperLogLogAvg>(12, k);
+        benches.emplace_back("hll_avg_add/b:12/k:" + std::to_string(k), [avg, stream](std::uint64_t n) {
+            std::uint64_t bytes = 0;
+            for (std::uint64_t i = 0; i < n; ++i) {
+                std::string_view key = stream->views[i & (kStream - 1)];
+                avg->add(key);
+                bytes += key.size();
+            }
+            return bytes;
+        });
+    }
+
+    return benches;
+}
+
+static std::map<std::string, double> loadBaseline(const std::string& path) {
+    std::map<std::string, double> baseline;
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "Cannot open baseline " << path << std::endl;
+        return baseline;
+    }
+    std::string line;
+    std::getline(in, line);
+    while (std::getline(in, line)) {
+        std::istringstream row(line);
+        std::string name, iterations, ns;
+        if (std::getline(row, name, ',') && std::getline(row, iterations, ',') &&
+            std::getline(row, ns, ',')) {
+            baseline[name] = std::stod(ns);
+        }
+    }
+    return baseline;
+}
+
+static void writeCsv(const std::string& path, const std::vector<BenchResult>& results) {
+    std::ofstream out(path);
+    out << "name,iterations,ns_per_op,items_per_sec,bytes_per_sec\n";
+    out << std::setprecision(6);
+    for (const auto& r : results) {
+        out << r.name << "," << r.iterations << "," << r.ns_per_op << ","
+            << r.items_per_sec << "," << r.bytes_per_sec << "\n";
+    }
+    std::cout << "Exported: " << path << std::endl;
+}
+
+static void writeJson(const std::string& path, const std::vector<BenchResult>& results) {
+    std::ofstream out(path);
+    out << "{\n  \"benchmarks\": [\n";
+    out << std::setprecision(6);
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const auto& r = results[i];
+        out << "    {\"name\": \"" << r.name << "\", \"iterations\": " << r.iterations
+            << ", \"ns_per_op\": " << r.ns_per_op
+            << ", \"items_per_sec\": " << r.items_per_sec
+            << ", \"bytes_per_sec\": " << r.bytes_per_sec << "}"
+            << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+    std::cout << "Exported: " << path << std::endl;
+}
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&](const std::string& prefix) { return arg.substr(prefix.size()); };
+        if (arg.rfind("--filter=", 0) == 0) {
+            options.filter = value("--filter=");
+        } else if (arg.rfind("--min-time=", 0) == 0) {
+            options.min_time = std::stod(value("--min-time="));
+        } else if (arg.rfind("--repetitions=", 0) == 0) {
+            options.repetitions = std::max(1, std::stoi(value("--repetitions=")));
+        } else if (arg.rfind("--csv=", 0) == 0) {
+            options.csv_path = value("--csv=");
+        } else if (arg.rfind("--json=", 0) == 0) {
+            options.json_path = value("--json=");
+        } else if (arg.rfind("--baseline=", 0) == 0) {
+            options.baseline_path = value("--baseline=");
+        } else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--filter=SUBSTR] [--min-time=SEC] [--repetitions=N]"
+                      << " [--csv=FILE] [--json=FILE] [--baseline=FILE.csv]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::map<std::string, double> baseline;
+    if (!options.baseline_path.empty())
+        baseline = loadBaseline(options.baseline_path);
+
+    std::cout << std::left << std::setw(28) << "benchmark"
+              << std::right << std::setw(14) << "iterations"
+              << std::setw(12) << "ns/op"
+              << std::setw(14) << "Mitems/s"
+              << std::setw(12) << "MB/s";
+    if (!baseline.empty())
+        std::cout << std::setw(10) << "vs base";
+    std::cout << std::endl;
+
+    std::vector<BenchResult> results;
+    for (const auto& [name, body] : registerBenchmarks()) {
+        if (!options.filter.empty() && name.find(options.filter) == std::string::npos)
+            continue;
+        BenchResult r = runBench(name, body, options);
+        results.push_back(r);
+
+        std::cout << std::left << std::setw(28) << r.name
+                  << std::right << std::setw(14) << r.iterations
+                  << std::fixed << std::setprecision(2)
+                  << std::setw(12) << r.ns_per_op
+                  << std::setw(14) << r.items_per_sec / 1e6
+                  << std::setw(12) << r.bytes_per_sec / 1e6;
+        auto it = baseline.find(r.name);
+        if (it != baseline.end() && it->second > 0.0) {
+            std::cout << std::showpos << std::setw(9) << (r.ns_per_op / it->second - 1.0) * 100.0
+                      << "%" << std::noshowpos;
+        }
+        std::cout << std::defaultfloat << std::endl;
+    }
+
+    if (!options.csv_path.empty())
+        writeCsv(options.csv_path, results);
+    if (!options.json_path.empty())
+        writeJson(options.json_path, results);
+    return 0;
+}
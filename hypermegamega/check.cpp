@@ -0,0 +1,114 @@
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "HyperLogLog.hpp"
+#include "SlidingHyperLogLog.hpp"
+
+// Deserialize must reject every buffer that is not a whole sketch. Small
+// buffers are cut at every length, large ones at a few.
+static bool rejectsCuts(const std::vector<std::uint8_t>& data) {
+    std::vector<std::size_t> cuts;
+    if (data.size() <= 4096) {
+        for (std::size_t cut = 0; cut < data.size(); ++cut)
+            cuts.push_back(cut);
+    } else {
+        cuts = {0, 11, 12, data.size() / 2, data.size() - 1};
+    }
+    for (std::size_t cut : cuts) {
+        try {
+            HyperLogLog::deserialize(data.data(), cut);
+            return false;
+        } catch (const std::invalid_argument&) {
+        }
+    }
+    return true;
+}
+
+// Round-trips empty, sparse-sized and dense-sized sketches for both hash
+// widths, every precision and both starting modes, and checks that cut and
+// wrong-version buffers are rejected. Returns the number of failures.
+static int checkSerialization() {
+    int failures = 0;
+    for (HashKind hash : {HashKind::Murmur3_32, HashKind::WyHash64}) {
+        for (int b = 4; b <= HyperLogLog::maxPrecision(hash); ++b) {
+            for (bool sparse : {false, true}) {
+                for (std::uint64_t n : {0, 1000, 50000}) {
+                    std::string name = "hash " + std::to_string(static_cast<int>(hash)) +
+                                       ", b " + std::to_string(b) +
+                                       (sparse ? ", sparse" : ", dense") +
+                                       ", " + std::to_string(n) + " keys";
+                    HyperLogLog hll(b, 0x9747b28c, hash, sparse);
+                    for (std::uint64_t i = 0; i < n; ++i)
+                        hll.add(std::to_string(i));
+                    std::vector<std::uint8_t> data = hll.serialize();
+
+                    std::string error;
+                    try {
+                        HyperLogLog copy = HyperLogLog::deserialize(data.data(), data.size());
+                        if (copy.serialize() != data || copy.isSparse() != hll.isSparse() ||
+                            copy.estimate() != hll.estimate())
+                            error = "round trip changed the sketch";
+                    } catch (const std::exception& e) {
+                        error = std::string("round trip failed: ") + e.what();
+                    }
+                    if (error.empty() && !rejectsCuts(data))
+                        error = "truncated buffer accepted";
+                    if (error.empty()) {
+                        std::vector<std::uint8_t> other = data;
+                        ++other[3];
+                        try {
+                            HyperLogLog::deserialize(other.data(), other.size());
+                            error = "other format version accepted";
+                        } catch (const std::invalid_argument&) {
+                        }
+                    }
+                    if (!error.empty()) {
+                        std::cerr << "serialization: " << name << ": " << error << std::endl;
+                        ++failures;
+                    }
+                }
+            }
+        }
+    }
+    return failures;
+}
+
+// Feeds 100 fresh keys per time unit into a window with slices of width 10
+// and checks that windows aligned to slice boundaries count only their own
+// keys. Returns the number of failures.
+static int checkSlidingWindow() {
+    const std::uint64_t per_tick = 100;
+    SlidingHyperLogLog sliding(14, 1000, 100, 0x9747b28c, HashKind::WyHash64);
+    for (std::uint64_t t = 0; t < 1000; ++t) {
+        for (std::uint64_t i = 0; i < per_tick; ++i)
+            sliding.add(std::to_string(t * per_tick + i), t);
+    }
+
+    int failures = 0;
+    for (std::uint64_t length : {10, 100, 500, 1000}) {
+        double truth = static_cast<double>(length * per_tick);
+        double estimate = sliding.estimate(999, length);
+        // Five standard errors at b = 14.
+        if (std::abs(estimate - truth) > 0.05 * truth) {
+            std::cerr << "sliding window: window(999, " << length << ") = " << estimate
+                      << ", expected about " << truth << std::endl;
+            ++failures;
+        }
+    }
+    return failures;
+}
+
+static int report(const char* name, int failures) {
+    std::cout << name << (failures == 0 ? ": passed" : ": failed") << std::endl;
+    return failures;
+}
+
+int main() {
+    int failures = report("serialization", checkSerialization());
+    failures += report("sliding window", checkSlidingWindow());
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,248 @@
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "HyperLogLog.hpp"
+
+struct Options {
+    std::optional<int> b;
+    std::optional<HashKind> hash;
+    bool sparse = false;
+    std::uint64_t every = 0;
+    std::string dump_path;
+    std::vector<std::string> merge_paths;
+    std::vector<std::string> inputs;
+};
+
+class LineCounter {
+public:
+    LineCounter(HyperLogLog& hll, std::uint64_t every)
+        : hll_(hll)
+        , every_(every)
+        , next_report_(every) {
+    }
+
+    // Adds every complete line in [begin, end) and returns the number of
+    // bytes consumed; a trailing partial line is left for the caller. Nothing
+    // points into the range afterwards, so the caller may reuse the buffer.
+    std::size_t consume(const char* begin, const char* end) {
+        const char* p = begin;
+        while (p < end) {
+            const char* nl = static_cast<const char*>(std::memchr(p, '\n', end - p));
+            if (nl == nullptr)
+                break;
+            push(std::string_view(p, nl - p));
+            p = nl + 1;
+        }
+        flush();
+        return p - begin;
+    }
+
+    void finish(const char* begin, const char* end) {
+        std::size_t used = consume(begin, end);
+        if (begin + used < end)
+            push(std::string_view(begin + used, end - begin - used));
+        flush();
+    }
+
+private:
+    static constexpr std::size_t kBatch = 256;
+
+    HyperLogLog& hll_;
+    std::uint64_t every_;
+    std::uint64_t next_report_;
+    std::uint64_t lines_ = 0;
+    std::string_view batch_[kBatch];
+    std::size_t pending_ = 0;
+
+    void push(std::string_view line) {
+        batch_[pending_++] = line;
+        ++lines_;
+        if (pending_ == kBatch)
+            flush();
+        if (every_ != 0 && lines_ == next_report_) {
+            flush();
+            std::cerr << lines_ << " lines, ~" << std::llround(hll_.estimate())
+                      << " distinct" << std::endl;
+            next_report_ += every_;
+        }
+    }
+
+    void flush() {
+        hll_.addBatch(batch_, pending_);
+        pending_ = 0;
+    }
+};
+
+static void countFd(int fd, const std::string& name, LineCounter& counter) {
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        std::size_t size = static_cast<std::size_t>(st.st_size);
+        void* p = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            ::madvise(p, size, MADV_SEQUENTIAL);
+            const char* data = static_cast<const char*>(p);
+            counter.finish(data, data + size);
+            ::munmap(p, size);
+            return;
+        }
+    }
+
+    std::vector<char> buffer(1 << 20);
+    std::size_t filled = 0;
+    while (true) {
+        if (filled == buffer.size())
+            buffer.resize(buffer.size() * 2);
+        ssize_t n = ::read(fd, buffer.data() + filled, buffer.size() - filled);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            throw std::system_error(errno, std::generic_category(), "cannot read " + name);
+        }
+        if (n == 0)
+            break;
+        filled += static_cast<std::size_t>(n);
+        std::size_t used = counter.consume(buffer.data(), buffer.data() + filled);
+        std::memmove(buffer.data(), buffer.data() + used, filled - used);
+        filled -= used;
+    }
+    counter.finish(buffer.data(), buffer.data() + filled);
+}
+
+static void countPath(const std::string& path, LineCounter& counter) {
+    if (path == "-") {
+        countFd(STDIN_FILENO, "stdin", counter);
+        return;
+    }
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::system_error(errno, std::generic_category(), "cannot open " + path);
+    try {
+        countFd(fd, path, counter);
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    ::close(fd);
+}
+
+static HyperLogLog loadSketch(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        throw std::invalid_argument("cannot open sketch " + path);
+    std::vector<std::uint8_t> data((std::istreambuf_iterator<char>(in)),
+                                   std::istreambuf_iterator<char>());
+    return HyperLogLog::deserialize(data.data(), data.size());
+}
+
+static HashKind parseHash(const std::string& name) {
+    if (name == "murmur3")
+        return HashKind::Murmur3_32;
+    if (name == "murmur3_128")
+        return HashKind::Murmur3_128;
+    if (name == "xxh64")
+        return HashKind::XXH64;
+    if (name == "wyhash")
+        return HashKind::WyHash64;
+    throw std::invalid_argument("unknown hash " + name +
+                                " (expected murmur3, murmur3_128, xxh64 or wyhash)");
+}
+
+static void usage(const char* argv0) {
+    std::cerr << "Usage: " << argv0 << " [options] [FILE...]\n"
+              << "Estimates the number of distinct lines in FILEs (or stdin).\n"
+              << "  -b B            precision, 4..24 (4..16 with murmur3; default 14)\n"
+              << "  -H HASH         murmur3, murmur3_128, xxh64, wyhash (default wyhash)\n"
+              << "  --sparse        start in sparse mode (small inputs use less memory)\n"
+              << "  --every N       print a running estimate to stderr every N lines\n"
+              << "  --dump FILE     write the serialized sketch to FILE\n"
+              << "  --merge FILE    merge a serialized sketch (may be repeated)\n";
+}
+
+static Options parseOptions(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc)
+                throw std::invalid_argument(arg + " needs a value");
+            return argv[++i];
+        };
+        if (arg == "-b") {
+            options.b = std::stoi(value());
+        } else if (arg == "-H") {
+            options.hash = parseHash(value());
+        } else if (arg == "--sparse") {
+            options.sparse = true;
+        } else if (arg == "--every") {
+            options.every = std::stoull(value());
+        } else if (arg == "--dump") {
+            options.dump_path = value();
+        } else if (arg == "--merge") {
+            options.merge_paths.push_back(value());
+        } else if (arg == "-h" || arg == "--help") {
+            usage(argv[0]);
+            std::exit(0);
+        } else if (arg.size() > 1 && arg[0] == '-' && arg != "-") {
+            throw std::invalid_argument("unknown option " + arg);
+        } else {
+            options.inputs.push_back(arg);
+        }
+    }
+    if (options.inputs.empty() && options.merge_paths.empty())
+        options.inputs.push_back("-");
+    return options;
+}
+
+int main(int argc, char** argv) {
+    try {
+        Options options = parseOptions(argc, argv);
+        std::vector<HyperLogLog> merged;
+        for (const auto& path : options.merge_paths) {
+            merged.push_back(loadSketch(path));
+        }
+        // Merged sketches fix the parameters unless they were given explicitly.
+        int b = options.b.value_or(merged.empty() ? 14 : merged.front().precision());
+        HashKind hash = options.hash.value_or(
+            merged.empty() ? HashKind::WyHash64 : merged.front().hashKind());
+        std::uint32_t seed = merged.empty() ? 0x9747b28c : merged.front().seed();
+
+        HyperLogLog hll(b, seed, hash, options.sparse);
+        for (const auto& other : merged) {
+            hll.merge(other);
+        }
+
+        LineCounter counter(hll, options.every);
+        for (const auto& path : options.inputs) {
+            countPath(path, counter);
+        }
+
+        if (!options.dump_path.empty()) {
+            std::vector<std::uint8_t> data = hll.serialize();
+            std::ofstream out(options.dump_path, std::ios::binary);
+            out.write(reinterpret_cast<const char*>(data.data()),
+                      static_cast<std::streamsize>(data.size()));
+            if (!out)
+                throw std::invalid_argument("cannot write sketch " + options.dump_path);
+        }
+
+        std::cout << std::llround(hll.estimate()) << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << argv[0] << ": " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -1,58 +1,84 @@
+#include <algorithm>
 #include <cmath>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
 #include <vector>
-#include "HyperLogLog.hpp"
-#include "HyperLogLogAvg.hpp"
-#include "RandomStreamGen.hpp"
-
-int main() {
-    const int B = 12;
-    const std::size_t K = 7;
-    const std::size_t stream_size = 10000;
-    const std::size_t num_streams = 100;
-    const std::vector<double> prefixes = {
+#include "ExperimentRunner.hpp"
+
+static int run(int argc, char** argv) {
+    ExperimentConfig config;
+    config.prefixes = {
         0.05, 0.1, 0.15, 0.2, 0.25, 0.3, 0.35, 0.4, 0.45, 0.5,
         0.55, 0.6, 0.65, 0.7, 0.75, 0.8, 0.85, 0.9, 0.95, 1.0};
 
-    RandomStreamGen gen(42);
+    unsigned int threads = std::max(1u, std::thread::hardware_concurrency());
+    if (argc > 1)
+        threads = static_cast<unsigned int>(std::stoul(argv[1]));
+    if (argc > 2)
+        config.b = std::stoi(argv[2]);
+    if (argc > 3)
+        config.k = std::stoul(argv[3]);
+    if (argc > 4)
+        config.num_streams = std::stoul(argv[4]);
+    if (argc > 5)
+        config.stream_size = std::stoul(argv[5]);
+    if (argc > 6) {
+        const std::string workload = argv[6];
+        const std::size_t colon = workload.find(':');
+        const std::string kind = workload.substr(0, colon);
+        const std::string args = colon == std::string::npos ? "" : workload.substr(colon + 1);
+        if (kind == "uniform") {
+            config.workload.keys = RandomStreamGen::KeyDistribution::Uniform;
+            config.workload.universe = std::stoull(args);
+        } else if (kind == "zipf") {
+            config.workload.keys = RandomStreamGen::KeyDistribution::Zipf;
+            config.workload.universe = std::stoull(args);
+            const std::size_t sep = args.find(':');
+            if (sep != std::string::npos)
+                config.workload.zipf_exponent = std::stod(args.substr(sep + 1));
+        } else if (kind == "replay") {
+            config.workload.keys = RandomStreamGen::KeyDistribution::Replay;
+            config.key_file = args;
+        } else if (kind != "unique") {
+            std::cerr << "Unknown workload " << workload
+                      << " (expected unique, uniform:D, zipf:D[:s] or replay:FILE)" << std::endl;
+            return 1;
+        }
+    }
 
-    HyperLogLog hll(B);
-    HyperLogLogAvg hll_avg(B, K);
+    const int B = config.b;
+    const std::size_t K = config.k;
+    const std::size_t stream_size = config.stream_size;
+    const std::size_t num_streams = config.num_streams;
+    const std::vector<double>& prefixes = config.prefixes;
 
-    std::vector<std::vector<double>> est_base(prefixes.size());
-    std::vector<std::vector<double>> est_avg(prefixes.size());
-    std::vector<std::vector<std::size_t>> exact_counts(prefixes.size());
+    ExperimentRunner runner(config);
 
     std::cout << "Running experiments: B=" << B
               << ", k=" << K
               << ", streams=" << num_streams
-              << ", stream_size=" << stream_size << std::endl;
+              << ", stream_size=" << stream_size
+              << ", threads=" << threads << std::endl;
 
-    for (std::size_t stream_idx = 0; stream_idx < num_streams; ++stream_idx) {
-        auto stream = gen.generateStream(stream_size);
-        hll.reset();
-        hll_avg.reset();
-
-        std::size_t prev_size = 0;
-        for (std::size_t p_idx = 0; p_idx < prefixes.size(); ++p_idx) {
-            std::size_t prefix_size =
-                static_cast<std::size_t>(stream_size * prefixes[p_idx]);
-
-            for (std::size_t i = prev_size; i < prefix_size; ++i) {
-                hll.add(stream[i]);
-                hll_avg.add(stream[i]);
-            }
-            prev_size = prefix_size;
-
-            est_base[p_idx].push_back(hll.estimate());
-            est_avg[p_idx].push_back(hll_avg.estimateMean());
-            exact_counts[p_idx].push_back(hll.exactCount());
+    std::size_t progress_step = std::max<std::size_t>(1, num_streams / 10);
+    auto results = runner.runAll(threads, [&](std::size_t done) {
+        if (done % progress_step == 0) {
+            std::cout << "  Processed " << done << " / " << num_streams << " streams" << std::endl;
         }
+    });
 
-        if ((stream_idx + 1) % 10 == 0) {
-            std::cout << "  Processed " << (stream_idx + 1) << " / " << num_streams << " streams" << std::endl;
+    std::vector<std::vector<double>> est_base(prefixes.size());
+    std::vector<std::vector<double>> est_avg(prefixes.size());
+    std::vector<std::vector<std::size_t>> exact_counts(prefixes.size());
+    for (const auto& r : results) {
+        for (std::size_t p_idx = 0; p_idx < prefixes.size(); ++p_idx) {
+            est_base[p_idx].push_back(r.base[p_idx]);
+            est_avg[p_idx].push_back(r.avg[p_idx]);
+            exact_counts[p_idx].push_back(r.exact[p_idx]);
         }
     }
 
@@ -98,25 +124,15 @@ int main() {
     }
 
     {
-        auto stream = gen.generateStream(stream_size);
-        hll.reset();
-        hll_avg.reset();
+        StreamEstimates single = runner.runStream(num_streams);
 
         std::ofstream out1("single_stream.csv");
         out1 << "prefix_percent,F0,N_base,N_avg\n";
 
-        std::size_t prev_size = 0;
-        for (double p : prefixes) {
-            std::size_t prefix_size = static_cast<std::size_t>(stream_size * p);
-            for (std::size_t i = prev_size; i < prefix_size; ++i) {
-                hll.add(stream[i]);
-                hll_avg.add(stream[i]);
-            }
-            prev_size = prefix_size;
-
-            out1 << std::fixed << std::setprecision(2) << (p * 100.0) << ","
-                 << hll.exactCount() << "," << hll.estimate() << ","
-                 << hll_avg.estimateMean() << "\n";
+        for (std::size_t i = 0; i < prefixes.size(); ++i) {
+            out1 << std::fixed << std::setprecision(2) << (prefixes[i] * 100.0) << ","
+                 << single.exact[i] << "," << single.base[i] << ","
+                 << single.avg[i] << "\n";
         }
 
         std::cout << "Exported: single_stream.csv" << std::endl;
@@ -171,4 +187,16 @@ int main() {
 
     std::cout << std::endl;
     std::cout << "To generate plots: python plot.py" << std::endl;
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    try {
+        return run(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        std::cerr << "Usage: " << argv[0]
+                  << " [threads] [B] [K] [NUM_STREAMS] [STREAM_SIZE] [WORKLOAD]" << std::endl;
+        return 1;
+    }
 }
@@ -1,9 +1,15 @@
 #include <algorithm>
+#include <array>
+#include <chrono>
 #include <cmath>
+#include <cstdint>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <random>
+#include <string>
+#include <thread>
+#include <vector>
 
 using namespace std;
 
@@ -46,7 +52,463 @@ double monte_carlo_area(const Circle& c1, const Circle& c2, const Circle& c3,
     return rect_area * static_cast<double>(inside) / total_points;
 }
 
-int main() {
+// Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3").
+// The output depends only on (counter, key), so any point can be generated
+// independently of the others and the result does not depend on which thread
+// produced it.
+array<uint32_t, 4> philox4x32(array<uint32_t, 4> ctr, array<uint32_t, 2> key) {
+    const uint32_t M0 = 0xD2511F53, M1 = 0xCD9E8D57;
+    const uint32_t W0 = 0x9E3779B9, W1 = 0xBB67AE85;
+    for (int round = 0; round < 10; ++round) {
+        uint64_t p0 = static_cast<uint64_t>(M0) * ctr[0];
+        uint64_t p1 = static_cast<uint64_t>(M1) * ctr[2];
+        ctr = {static_cast<uint32_t>(p1 >> 32) ^ ctr[1] ^ key[0],
+               static_cast<uint32_t>(p1),
+               static_cast<uint32_t>(p0 >> 32) ^ ctr[3] ^ key[1],
+               static_cast<uint32_t>(p0)};
+        key[0] += W0;
+        key[1] += W1;
+    }
+    return ctr;
+}
+
+double to_unit(uint32_t hi, uint32_t lo) {
+    return static_cast<double>(((static_cast<uint64_t>(hi) << 32) | lo) >> 11) *
+           0x1.0p-53;
+}
+
+const size_t kBatch = 1024;
+
+// Counts points of the batch [first, first + kBatch) of stream `stream` that
+// fall into the intersection. Coordinates are stored as separate x and y
+// arrays and the test is branchless, so the compiler vectorizes the loop.
+uint64_t count_batch(const Circle& c1, const Circle& c2, const Circle& c3,
+                     double min_x, double width, double min_y, double height,
+                     uint64_t first, size_t count, uint32_t stream, uint64_t seed) {
+    alignas(64) double xs[kBatch];
+    alignas(64) double ys[kBatch];
+    array<uint32_t, 2> key = {static_cast<uint32_t>(seed),
+                              static_cast<uint32_t>(seed >> 32)};
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t idx = first + i;
+        auto r = philox4x32({static_cast<uint32_t>(idx),
+                             static_cast<uint32_t>(idx >> 32), stream, 0},
+                            key);
+        xs[i] = min_x + width * to_unit(r[0], r[1]);
+        ys[i] = min_y + height * to_unit(r[2], r[3]);
+    }
+
+    const double r1 = c1.r * c1.r, r2 = c2.r * c2.r, r3 = c3.r * c3.r;
+    uint64_t inside = 0;
+    for (size_t i = 0; i < count; ++i) {
+        double x = xs[i], y = ys[i];
+        double d1 = (x - c1.x) * (x - c1.x) + (y - c1.y) * (y - c1.y);
+        double d2 = (x - c2.x) * (x - c2.x) + (y - c2.y) * (y - c2.y);
+        double d3 = (x - c3.x) * (x - c3.x) + (y - c3.y) * (y - c3.y);
+        inside += static_cast<uint64_t>((d1 <= r1) & (d2 <= r2) & (d3 <= r3));
+    }
+    return inside;
+}
+
+struct Chunk {
+    uint64_t first;
+    uint64_t count;
+};
+
+const uint64_t kChunk = 64 * kBatch;
+
+// Splits [0, checkpoints.back()) into chunks of at most kChunk points that
+// never cross a checkpoint, so every prefix count is a sum of whole chunks.
+vector<Chunk> make_chunks(const vector<uint64_t>& checkpoints) {
+    vector<Chunk> chunks;
+    uint64_t pos = 0;
+    for (uint64_t cp : checkpoints) {
+        while (pos < cp) {
+            uint64_t count = min(kChunk, cp - pos);
+            chunks.push_back({pos, count});
+            pos += count;
+        }
+    }
+    return chunks;
+}
+
+// Counts hits in every chunk; chunks are split between threads, and each
+// chunk's count depends only on its points, so the output does not depend on
+// the number of threads.
+vector<uint64_t> count_chunks(const Circle& c1, const Circle& c2,
+                              const Circle& c3, double min_x, double width,
+                              double min_y, double height,
+                              const vector<Chunk>& chunks, uint64_t seed,
+                              uint32_t stream, unsigned threads) {
+    vector<uint64_t> counts(chunks.size(), 0);
+    threads = max(1u, min<unsigned>(threads, static_cast<unsigned>(max<size_t>(chunks.size(), 1))));
+
+    auto worker = [&](unsigned t) {
+        for (size_t i = t; i < chunks.size(); i += threads) {
+            uint64_t inside = 0;
+            for (uint64_t off = 0; off < chunks[i].count; off += kBatch) {
+                size_t count = static_cast<size_t>(min<uint64_t>(kBatch, chunks[i].count - off));
+                inside += count_batch(c1, c2, c3, min_x, width, min_y, height,
+                                      chunks[i].first + off, count, stream, seed);
+            }
+            counts[i] = inside;
+        }
+    };
+
+    vector<thread> pool;
+    for (unsigned t = 1; t < threads; ++t) {
+        pool.emplace_back(worker, t);
+    }
+    worker(0);
+    for (auto& th : pool) {
+        th.join();
+    }
+    return counts;
+}
+
+struct SweepPoint {
+    uint64_t n;
+    double area;
+    double std_error;
+};
+
+// One pass over checkpoints.back() points of Philox stream `stream`: the
+// estimate at each checkpoint N uses the first N points, together with its
+// standard error rect_area * sqrt(p * (1 - p) / N).
+vector<SweepPoint> monte_carlo_sweep(const Circle& c1, const Circle& c2,
+                                     const Circle& c3, double min_x,
+                                     double max_x, double min_y, double max_y,
+                                     vector<uint64_t> checkpoints,
+                                     uint64_t seed, uint32_t stream,
+                                     unsigned threads) {
+    sort(checkpoints.begin(), checkpoints.end());
+    checkpoints.erase(unique(checkpoints.begin(), checkpoints.end()),
+                      checkpoints.end());
+    checkpoints.erase(remove(checkpoints.begin(), checkpoints.end(), 0),
+                      checkpoints.end());
+
+    double width = max_x - min_x;
+    double height = max_y - min_y;
+    double rect_area = width * height;
+    vector<Chunk> chunks = make_chunks(checkpoints);
+    vector<uint64_t> counts = count_chunks(c1, c2, c3, min_x, width, min_y,
+                                           height, chunks, seed, stream, threads);
+
+    vector<SweepPoint> result;
+    result.reserve(checkpoints.size());
+    uint64_t inside = 0;
+    size_t next = 0;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        inside += counts[i];
+        uint64_t n = chunks[i].first + chunks[i].count;
+        if (n == checkpoints[next]) {
+            double p = static_cast<double>(inside) / static_cast<double>(n);
+            result.push_back({n, rect_area * p,
+                              rect_area * sqrt(p * (1.0 - p) / static_cast<double>(n))});
+            ++next;
+        }
+    }
+    return result;
+}
+
+// Same estimate as monte_carlo_area, but points come from Philox stream
+// `stream` and are split between threads in fixed chunks. The result depends
+// only on seed, stream and total_points, not on the number of threads.
+// Without points there is nothing to estimate, and the result is 0.
+double monte_carlo_area_parallel(const Circle& c1, const Circle& c2,
+                                 const Circle& c3, double min_x, double max_x,
+                                 double min_y, double max_y,
+                                 uint64_t total_points, uint64_t seed,
+                                 uint32_t stream, unsigned threads) {
+    vector<SweepPoint> sweep =
+        monte_carlo_sweep(c1, c2, c3, min_x, max_x, min_y, max_y,
+                          {total_points}, seed, stream, threads);
+    return sweep.empty() ? 0.0 : sweep.back().area;
+}
+
+array<double, 2> philox_uniform2(uint64_t idx, uint32_t stream, uint64_t seed) {
+    auto r = philox4x32({static_cast<uint32_t>(idx), static_cast<uint32_t>(idx >> 32),
+                         stream, 0},
+                        {static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)});
+    return {to_unit(r[0], r[1]), to_unit(r[2], r[3])};
+}
+
+enum class Estimator {
+    Uniform,
+    UniformPhilox,
+    Stratified,
+    LatinHypercube,
+    Halton,
+    Sobol,
+    Importance,
+};
+
+const char* estimator_name(Estimator e) {
+    switch (e) {
+    case Estimator::Uniform:
+        return "uniform_mt19937";
+    case Estimator::UniformPhilox:
+        return "uniform_philox";
+    case Estimator::Stratified:
+        return "stratified";
+    case Estimator::LatinHypercube:
+        return "latin_hypercube";
+    case Estimator::Halton:
+        return "halton";
+    case Estimator::Sobol:
+        return "sobol";
+    default:
+        return "importance";
+    }
+}
+
+// Pseudorandom permutation of [0, n): a 4-round Feistel network on the
+// smallest even number of bits covering n, with cycle walking for indices
+// that fall outside the range. Needs no memory, unlike shuffling an array.
+uint64_t permute(uint64_t i, uint64_t n, uint64_t seed) {
+    int half = 1;
+    while ((1ULL << (2 * half)) < n) {
+        ++half;
+    }
+    uint64_t mask = (1ULL << half) - 1;
+    do {
+        uint64_t left = i >> half, right = i & mask;
+        for (uint32_t round = 0; round < 4; ++round) {
+            auto f = philox4x32({static_cast<uint32_t>(right), round, 7, 0},
+                                {static_cast<uint32_t>(seed),
+                                 static_cast<uint32_t>(seed >> 32)});
+            uint64_t next = left ^ (f[0] & mask);
+            left = right;
+            right = next;
+        }
+        i = (left << half) | right;
+    } while (i >= n);
+    return i;
+}
+
+double radical_inverse(uint64_t i, uint32_t base) {
+    double inv = 1.0 / base, f = inv, r = 0.0;
+    while (i > 0) {
+        r += f * static_cast<double>(i % base);
+        i /= base;
+        f *= inv;
+    }
+    return r;
+}
+
+// Exit distance of the ray p + t * (ux, uy) from circle c, for p inside c.
+double ray_exit(double px, double py, double ux, double uy, const Circle& c) {
+    double bx = px - c.x, by = py - c.y;
+    double b = ux * bx + uy * by;
+    double cc = bx * bx + by * by - c.r * c.r;
+    return -b + sqrt(b * b - cc);
+}
+
+// Side of the Stratified grid for a budget of n points; the estimator draws
+// k * k points, which is n only when n is a perfect square.
+uint64_t stratified_side(uint64_t n) {
+    return max<uint64_t>(1, static_cast<uint64_t>(llround(sqrt(static_cast<double>(n)))));
+}
+
+// Number of points estimate_area(e, ..., n, ...) actually draws.
+uint64_t points_drawn(Estimator e, uint64_t n) {
+    if (e == Estimator::Stratified) {
+        uint64_t k = stratified_side(n);
+        return k * k;
+    }
+    return n;
+}
+
+// Unbiased estimate of the intersection area from n samples of the chosen
+// estimator. All estimators except Importance draw points in the given
+// rectangle; Importance samples the intersection itself in polar coordinates
+// around the centroid of the centres. QMC sequences are randomized (shift /
+// digital shift) so that independent seeds give independent estimates.
+double estimate_area(Estimator e, const Circle& c1, const Circle& c2,
+                     const Circle& c3, double min_x, double max_x, double min_y,
+                     double max_y, uint64_t n, uint64_t seed, unsigned threads) {
+    double w = max_x - min_x, h = max_y - min_y;
+    uint64_t inside = 0;
+
+    switch (e) {
+    case Estimator::Uniform: {
+        mt19937 gen(static_cast<uint32_t>(seed));
+        return monte_carlo_area(c1, c2, c3, min_x, max_x, min_y, max_y,
+                                static_cast<int>(n), gen);
+    }
+    case Estimator::UniformPhilox:
+        return monte_carlo_area_parallel(c1, c2, c3, min_x, max_x, min_y, max_y,
+                                         n, seed, 2, threads);
+    case Estimator::Stratified: {
+        // One jittered point per cell of a k x k grid.
+        uint64_t k = stratified_side(n);
+        for (uint64_t a = 0; a < k; ++a) {
+            for (uint64_t b = 0; b < k; ++b) {
+                auto u = philox_uniform2(a * k + b, 3, seed);
+                double x = min_x + w * (static_cast<double>(a) + u[0]) / static_cast<double>(k);
+                double y = min_y + h * (static_cast<double>(b) + u[1]) / static_cast<double>(k);
+                inside += in_intersec(x, y, c1, c2, c3);
+            }
+        }
+        return w * h * static_cast<double>(inside) / static_cast<double>(k * k);
+    }
+    case Estimator::LatinHypercube: {
+        double dn = static_cast<double>(n);
+        for (uint64_t i = 0; i < n; ++i) {
+            auto u = philox_uniform2(i, 4, seed);
+            double x = min_x + w * (static_cast<double>(i) + u[0]) / dn;
+            double y = min_y + h * (static_cast<double>(permute(i, n, seed)) + u[1]) / dn;
+            inside += in_intersec(x, y, c1, c2, c3);
+        }
+        return w * h * static_cast<double>(inside) / dn;
+    }
+    case Estimator::Halton: {
+        auto shift = philox_uniform2(0, 5, seed);
+        for (uint64_t i = 0; i < n; ++i) {
+            double ux = radical_inverse(i, 2) + shift[0];
+            double uy = radical_inverse(i, 3) + shift[1];
+            double x = min_x + w * (ux - floor(ux));
+            double y = min_y + h * (uy - floor(uy));
+            inside += in_intersec(x, y, c1, c2, c3);
+        }
+        return w * h * static_cast<double>(inside) / static_cast<double>(n);
+    }
+    case Estimator::Sobol: {
+        // First two Sobol dimensions (van der Corput and the x + 1
+        // polynomial), Gray-code order, with a random digital shift.
+        uint32_t v1[32], v2[32];
+        uint32_t m = 1;
+        for (int k = 0; k < 32; ++k) {
+            v1[k] = 1u << (31 - k);
+            v2[k] = m << (31 - k);
+            m ^= m << 1;
+        }
+        auto r = philox4x32({0, 0, 6, 0}, {static_cast<uint32_t>(seed),
+                                           static_cast<uint32_t>(seed >> 32)});
+        uint32_t x_bits = 0, y_bits = 0;
+        for (uint64_t i = 0; i < n; ++i) {
+            double x = min_x + w * (static_cast<double>(x_bits ^ r[0]) + 0.5) * 0x1.0p-32;
+            double y = min_y + h * (static_cast<double>(y_bits ^ r[1]) + 0.5) * 0x1.0p-32;
+            inside += in_intersec(x, y, c1, c2, c3);
+            int c = __builtin_ctzll(~i);
+            x_bits ^= v1[c];
+            y_bits ^= v2[c];
+        }
+        return w * h * static_cast<double>(inside) / static_cast<double>(n);
+    }
+    default: {
+        // The intersection of discs is convex, so if it contains the centroid
+        // p of the centres it is exactly the set {p + t * u(theta),
+        // 0 <= t <= R(theta)}, and its area is the mean of pi R(theta)^2 over
+        // theta. Only the angle is sampled, jittered once per stratum of width
+        // 2 pi / n; R(theta) is computed exactly, so this is polar quadrature
+        // rather than sampling of points. Circles whose intersection misses
+        // the centroid fall back to uniform sampling of the rectangle.
+        double px = (c1.x + c2.x + c3.x) / 3.0, py = (c1.y + c2.y + c3.y) / 3.0;
+        if (!in_intersec(px, py, c1, c2, c3)) {
+            return monte_carlo_area_parallel(c1, c2, c3, min_x, max_x, min_y,
+                                             max_y, n, seed, 8, threads);
+        }
+        double sum = 0.0;
+        for (uint64_t i = 0; i < n; ++i) {
+            double u = philox_uniform2(i, 8, seed)[0];
+            double theta = 2.0 * M_PI * (static_cast<double>(i) + u) / static_cast<double>(n);
+            double ux = cos(theta), uy = sin(theta);
+            double r = min({ray_exit(px, py, ux, uy, c1), ray_exit(px, py, ux, uy, c2),
+                            ray_exit(px, py, ux, uy, c3)});
+            sum += M_PI * r * r;
+        }
+        return sum / static_cast<double>(n);
+    }
+    }
+}
+
+// For every estimator, doubles N from 2^10 to 2^max_log2 and measures the
+// RMSE of the relative error over `reps` independent seeds and the time of a
+// single run. Stops at the first N whose RMSE is at most `target`. N is
+// reported as the number of points actually drawn.
+void compare_estimators(const Circle& c1, const Circle& c2, const Circle& c3,
+                        double min_x, double max_x, double min_y, double max_y,
+                        double target, int max_log2, uint64_t seed,
+                        unsigned threads) {
+    const int reps = 8;
+    double S_exact = exact_area();
+    ofstream out("estimators_results.csv");
+    out << "Estimator,N,RMSE_Relative_Error,Seconds_Per_Run\n";
+
+    cout << "Target relative error " << scientific << setprecision(1) << target
+         << ", " << reps << " seeds per N\n" << fixed;
+    for (Estimator e : {Estimator::Uniform, Estimator::UniformPhilox,
+                        Estimator::Stratified, Estimator::LatinHypercube,
+                        Estimator::Halton, Estimator::Sobol,
+                        Estimator::Importance}) {
+        bool reached = false;
+        uint64_t n = 0;
+        double rmse = 0.0, seconds = 0.0;
+        for (int lg = 10; lg <= max_log2 && !reached; ++lg) {
+            n = 1ULL << lg;
+            double sq = 0.0;
+            auto start = chrono::steady_clock::now();
+            for (int rep = 0; rep < reps; ++rep) {
+                double S = estimate_area(e, c1, c2, c3, min_x, max_x, min_y,
+                                         max_y, n, seed + rep, threads);
+                sq += (S - S_exact) * (S - S_exact);
+            }
+            seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count() / reps;
+            rmse = sqrt(sq / reps) / S_exact;
+            out << estimator_name(e) << "," << points_drawn(e, n) << "," << rmse
+                << "," << seconds << "\n";
+            reached = rmse <= target;
+        }
+
+        cout << left << setw(18) << estimator_name(e) << right;
+        if (reached) {
+            cout << "  N = " << setw(10) << points_drawn(e, n) << "  rmse = " << scientific
+                 << setprecision(2) << rmse << "  time-to-target = "
+                 << fixed << setprecision(4) << seconds << " s\n";
+        } else {
+            // Plain Monte Carlo converges as 1 / sqrt(N).
+            double drawn = static_cast<double>(points_drawn(e, n));
+            double needed = drawn * (rmse / target) * (rmse / target);
+            cout << "  not reached at N = " << points_drawn(e, n) << " (rmse = " << scientific
+                 << setprecision(2) << rmse << ", ~" << needed
+                 << " points by 1/sqrt(N))\n" << fixed;
+        }
+    }
+    cout << "\nResults saved to estimators_results.csv\n";
+}
+
+int main(int argc, char** argv) {
+    unsigned threads = max(1u, thread::hardware_concurrency());
+    if (argc > 1 && string(argv[1]) == "compare") {
+        double target = argc > 2 ? stod(argv[2]) : 1e-4;
+        int max_log2 = argc > 3 ? stoi(argv[3]) : 24;
+        // N is passed around as int, and Sobol directions cover 32 bits.
+        if (max_log2 < 10 || max_log2 > 30) {
+            cerr << "Usage: " << argv[0] << " compare [target] [max_log2]\n"
+                 << "max_log2 must be in [10, 30]\n";
+            return 1;
+        }
+        Circle c1{1.0, 1.0, 1.0};
+        Circle c2{1.5, 2.0, sqrt(5.0) / 2.0};
+        Circle c3{2.0, 1.5, sqrt(5.0) / 2.0};
+        compare_estimators(c1, c2, c3, 0.88, 2.0, 0.88, 2.0, target, max_log2,
+                           2024, threads);
+        return 0;
+    }
+    if (argc > 1)
+        threads = static_cast<unsigned>(stoul(argv[1]));
+    uint64_t bigN = 1000000;
+    if (argc > 2)
+        bigN = stoull(argv[2]);
+    if (bigN == 0) {
+        cerr << "N must be positive\n";
+        return 1;
+    }
+    uint64_t seed = 2024;
+    if (argc > 3)
+        seed = stoull(argv[3]);
+
     Circle c1{1.0, 1.0, 1.0};
     Circle c2{1.5, 2.0, sqrt(5.0) / 2.0};
     Circle c3{2.0, 1.5, sqrt(5.0) / 2.0};
@@ -69,30 +531,37 @@ int main() {
     ofstream areas_file("areas_results.csv");
     ofstream errors_file("errors_results.csv");
 
-    areas_file << "N,Wide_Area,Narrow_Area,Exact_Area\n";
+    areas_file << "N,Wide_Area,Narrow_Area,Exact_Area,Wide_Std_Error,Narrow_Std_Error\n";
     errors_file << "N,Wide_Relative_Error,Narrow_Relative_Error\n";
 
-    random_device rd;
-    mt19937 gen(rd());
-
-    for (int N = 100; N <= 100000; N += 500) {
-        double S_wide = monte_carlo_area(c1, c2, c3, wide_min_x, wide_max_x,
-                                         wide_min_y, wide_max_y, N, gen);
+    vector<uint64_t> checkpoints;
+    for (uint64_t N = 100; N <= 100000; N += 500) {
+        checkpoints.push_back(N);
+    }
+    vector<SweepPoint> wide =
+        monte_carlo_sweep(c1, c2, c3, wide_min_x, wide_max_x, wide_min_y,
+                          wide_max_y, checkpoints, seed, 0, threads);
+    vector<SweepPoint> narrow =
+        monte_carlo_sweep(c1, c2, c3, narrow_min_x, narrow_max_x, narrow_min_y,
+                          narrow_max_y, checkpoints, seed, 1, threads);
 
-        double S_narrow =
-            monte_carlo_area(c1, c2, c3, narrow_min_x, narrow_max_x,
-                             narrow_min_y, narrow_max_y, N, gen);
+    for (size_t i = 0; i < checkpoints.size(); ++i) {
+        uint64_t N = checkpoints[i];
+        double S_wide = wide[i].area;
+        double S_narrow = narrow[i].area;
 
         double err_wide = fabs(S_wide - S_exact) / S_exact;
         double err_narrow = fabs(S_narrow - S_exact) / S_exact;
 
         areas_file << N << "," << S_wide << "," << S_narrow << "," << S_exact
+                   << "," << wide[i].std_error << "," << narrow[i].std_error
                    << "\n";
         errors_file << N << "," << err_wide << "," << err_narrow << "\n";
 
         if (N % 10000 == 100) {
-            cout << "N = " << N << "  wide = " << S_wide
-                 << "  narrow = " << S_narrow
+            cout << "N = " << N << "  wide = " << S_wide << " +- "
+                 << wide[i].std_error << "  narrow = " << S_narrow << " +- "
+                 << narrow[i].std_error
                  << "  err_wide = " << err_wide * 100 << "% "
                  << "  err_narrow = " << err_narrow * 100 << "%\n";
         }
@@ -101,14 +570,20 @@ int main() {
     areas_file.close();
     errors_file.close();
 
-    int bigN = 1000000;
-    double S_wide_big = monte_carlo_area(c1, c2, c3, wide_min_x, wide_max_x,
-                                         wide_min_y, wide_max_y, bigN, gen);
-    double S_narrow_big =
-        monte_carlo_area(c1, c2, c3, narrow_min_x, narrow_max_x, narrow_min_y,
-                         narrow_max_y, bigN, gen);
+    auto start = chrono::steady_clock::now();
+    double S_wide_big = monte_carlo_area_parallel(
+        c1, c2, c3, wide_min_x, wide_max_x, wide_min_y, wide_max_y, bigN, seed,
+        0, threads);
+    double S_narrow_big = monte_carlo_area_parallel(
+        c1, c2, c3, narrow_min_x, narrow_max_x, narrow_min_y, narrow_max_y, bigN,
+        seed, 1, threads);
+    double seconds =
+        chrono::duration<double>(chrono::steady_clock::now() - start).count();
 
-    cout << "\nFor N = " << bigN << ":\n";
+    cout << "\nFor N = " << bigN << " (seed " << seed << ", " << threads
+         << " threads, " << setprecision(1)
+         << 2.0 * static_cast<double>(bigN) / seconds / 1e6
+         << " M points/s):\n" << setprecision(15);
     cout << "Wide:   " << S_wide_big
          << "  (rel.error = " << fabs(S_wide_big - S_exact) / S_exact * 100
          << "%)\n";
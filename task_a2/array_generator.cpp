@@ -63,6 +63,16 @@ public:
                                 almost_sorted_array.begin() + size);
     }
 
+    std::vector<int> get_large_random_array(int size) {
+        std::mt19937 gen(size);
+        std::uniform_int_distribution<int> dist(MIN_RANGE, MAX_RANGE);
+        std::vector<int> arr(size);
+        for (int i = 0; i < size; i++) {
+            arr[i] = dist(gen);
+        }
+        return arr;
+    }
+
     std::vector<int> get_sizes() {
         std::vector<int> sizes;
         for (int size = 500; size <= 100000; size += 100) {
@@ -1,8 +1,12 @@
 #include <iostream>
 #include "array_generator.cpp"
+#include "sort_thresholds.cpp"
+#include "merge_sorter.cpp"
+#include "task_pool.cpp"
+#include "parallel_merge_sorter.cpp"
 #include "sort_tester.cpp"
 
-int main() {
+int main(int argc, char* argv[]) {
     std::cout << "SORTING ALGORITHM ANALYSIS" << std::endl;
     std::cout << std::endl;
 
@@ -10,7 +14,20 @@ int main() {
 
     SortTester tester(&generator);
 
+    if (!tester.verify_sorts()) {
+        return 1;
+    }
+
+    if (argc > 1 && std::string(argv[1]) == "calibrate") {
+        tester.calibrate();
+        return 0;
+    }
+    tester.load_thresholds();
+
     tester.run_tests();
+    if (!tester.run_parallel_tests()) {
+        return 1;
+    }
 
     std::cout << "Analysis completed!" << std::endl;
 
@@ -0,0 +1,478 @@
+#include <algorithm>
+#include <vector>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// Merge sort that owns a single scratch buffer and reuses it between calls,
+// so a sort does at most one allocation (none once the buffer is big enough).
+// Levels of the recursion alternate the roles of the array and the buffer,
+// which removes the copy back after every merge.
+class MergeSorter {
+private:
+    friend class ParallelMergeSorter;
+
+    // Bottom-up sort: runs of kRun are sorted by insertion sort, then merged
+    // inside kTile-sized tiles (64 KiB, fits in L2) before the passes that
+    // span the whole array.
+    static constexpr int kRun = 16;
+    static constexpr int kTile = 1 << 14;
+
+    // Natural merge sort: a side that wins this many times in a row switches
+    // the merge into galloping mode.
+    static constexpr int kMinGallop = 7;
+
+    struct Run {
+        int start;
+        int length;
+        int power;
+    };
+
+    std::vector<int> buffer;
+    SortThresholds thresholds;
+
+    static void insertion_sort(int* arr, int left, int right) {
+        for (int i = left + 1; i <= right; i++) {
+            int key = arr[i];
+            int j = i - 1;
+
+            while (j >= left && arr[j] > key) {
+                arr[j + 1] = arr[j];
+                j--;
+            }
+            arr[j + 1] = key;
+        }
+    }
+
+    static void merge(const int* src, int* dst, int left, int mid, int right) {
+        int i = left, j = mid + 1, k = left;
+
+        while (i <= mid && j <= right) {
+            if (src[i] <= src[j]) {
+                dst[k++] = src[i++];
+            } else {
+                dst[k++] = src[j++];
+            }
+        }
+
+        std::copy(src + i, src + mid + 1, dst + k);
+        std::copy(src + j, src + right + 1, dst + k + (mid + 1 - i));
+    }
+
+    // Sorts [left, right] into dst, using src as the scratch for the halves.
+    // Both arrays start with the same contents, so a leaf can be sorted in
+    // dst directly.
+    static void sort_into(int* src, int* dst, int left, int right, int threshold) {
+        if (right - left + 1 <= threshold) {
+            insertion_sort(dst, left, right);
+            return;
+        }
+
+        int mid = left + (right - left) / 2;
+        sort_into(dst, src, left, mid, threshold);
+        sort_into(dst, src, mid + 1, right, threshold);
+
+        if (src[mid] <= src[mid + 1]) {
+            std::copy(src + left, src + right + 1, dst + left);
+        } else {
+            merge(src, dst, left, mid, right);
+        }
+    }
+
+#ifdef __AVX2__
+    // Bitonic merge network: a and b are sorted, afterwards a holds the eight
+    // smallest of the sixteen values and b the eight largest, both sorted.
+    static void bitonic_merge(__m256i& a, __m256i& b) {
+        b = _mm256_permutevar8x32_epi32(b, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+        __m256i lo = _mm256_min_epi32(a, b);
+        __m256i hi = _mm256_max_epi32(a, b);
+
+        __m256i lo_x = _mm256_permute2x128_si256(lo, lo, 1);
+        __m256i hi_x = _mm256_permute2x128_si256(hi, hi, 1);
+        lo = _mm256_blend_epi32(_mm256_min_epi32(lo, lo_x), _mm256_max_epi32(lo, lo_x), 0xF0);
+        hi = _mm256_blend_epi32(_mm256_min_epi32(hi, hi_x), _mm256_max_epi32(hi, hi_x), 0xF0);
+
+        lo_x = _mm256_shuffle_epi32(lo, _MM_SHUFFLE(1, 0, 3, 2));
+        hi_x = _mm256_shuffle_epi32(hi, _MM_SHUFFLE(1, 0, 3, 2));
+        lo = _mm256_blend_epi32(_mm256_min_epi32(lo, lo_x), _mm256_max_epi32(lo, lo_x), 0xCC);
+        hi = _mm256_blend_epi32(_mm256_min_epi32(hi, hi_x), _mm256_max_epi32(hi, hi_x), 0xCC);
+
+        lo_x = _mm256_shuffle_epi32(lo, _MM_SHUFFLE(2, 3, 0, 1));
+        hi_x = _mm256_shuffle_epi32(hi, _MM_SHUFFLE(2, 3, 0, 1));
+        a = _mm256_blend_epi32(_mm256_min_epi32(lo, lo_x), _mm256_max_epi32(lo, lo_x), 0xAA);
+        b = _mm256_blend_epi32(_mm256_min_epi32(hi, hi_x), _mm256_max_epi32(hi, hi_x), 0xAA);
+    }
+#endif
+
+    // Merges sorted a[0, na) and b[0, nb) into out. With AVX2 the bulk goes
+    // through the bitonic network eight values at a time and only the tails
+    // are merged one by one.
+    static void merge_runs(const int* a, int na, const int* b, int nb, int* out) {
+        int i = 0, j = 0, k = 0;
+
+#ifdef __AVX2__
+        if (na >= 8 && nb >= 8) {
+            __m256i lo = _mm256_loadu_si256((const __m256i*)a);
+            __m256i hi = _mm256_loadu_si256((const __m256i*)b);
+            i = j = 8;
+            bitonic_merge(lo, hi);
+            _mm256_storeu_si256((__m256i*)out, lo);
+            k = 8;
+
+            while (i + 8 <= na && j + 8 <= nb) {
+                bool take_a = a[i] <= b[j];
+                lo = _mm256_loadu_si256((const __m256i*)(take_a ? a + i : b + j));
+                i += take_a ? 8 : 0;
+                j += take_a ? 0 : 8;
+                bitonic_merge(lo, hi);
+                _mm256_storeu_si256((__m256i*)(out + k), lo);
+                k += 8;
+            }
+
+            // The eight values left in hi still have to be merged with the
+            // tails of both runs.
+            int tail[8];
+            _mm256_storeu_si256((__m256i*)tail, hi);
+            for (int t = 0; t < 8; t++) {
+                while (true) {
+                    bool has_a = i < na && a[i] < tail[t];
+                    bool has_b = j < nb && b[j] < tail[t];
+                    if (has_a && (!has_b || a[i] <= b[j])) {
+                        out[k++] = a[i++];
+                    } else if (has_b) {
+                        out[k++] = b[j++];
+                    } else {
+                        break;
+                    }
+                }
+                out[k++] = tail[t];
+            }
+        }
+#endif
+
+        while (i < na && j < nb) {
+            if (a[i] <= b[j]) {
+                out[k++] = a[i++];
+            } else {
+                out[k++] = b[j++];
+            }
+        }
+
+        std::copy(a + i, a + na, out + k);
+        std::copy(b + j, b + nb, out + k + (na - i));
+    }
+
+    // Merges neighbouring runs of the given width in [lo, hi) from src to dst.
+    // Runs that are already in order, or in exactly reversed order, are
+    // just copied.
+    static void merge_pass(const int* src, int* dst, int lo, int hi, int width) {
+        for (int left = lo; left < hi; left += 2 * width) {
+            int mid = std::min(left + width, hi);
+            int right = std::min(mid + width, hi);
+
+            if (mid == right || src[mid - 1] <= src[mid]) {
+                std::copy(src + left, src + right, dst + left);
+            } else if (src[right - 1] < src[left]) {
+                std::copy(src + mid, src + right, dst + left);
+                std::copy(src + left, src + mid, dst + left + (right - mid));
+            } else {
+                merge_runs(src + left, mid - left, src + mid, right - mid, dst + left);
+            }
+        }
+    }
+
+    // Counts the merge passes bottom_up_sort makes after the run pass.
+    static int count_passes(int n, int tile) {
+        int passes = 0;
+        for (int width = kRun; width < tile; width *= 2) {
+            passes++;
+        }
+        for (int width = tile; width < n; width *= 2) {
+            passes++;
+        }
+        return passes;
+    }
+
+    void bottom_up_sort(std::vector<int>& arr) {
+        int n = arr.size();
+        if (n < 2) {
+            return;
+        }
+        if (buffer.size() < arr.size()) {
+            buffer.resize(arr.size());
+        }
+
+        int tile = std::min(kTile, n);
+        int* src = arr.data();
+        int* dst = buffer.data();
+
+        // Start in the buffer when the pass count is odd, so the last pass
+        // writes into arr and no final copy is needed.
+        if (count_passes(n, tile) % 2 == 1) {
+            std::copy(src, src + n, dst);
+            std::swap(src, dst);
+        }
+        for (int left = 0; left < n; left += kRun) {
+            insertion_sort(src, left, std::min(left + kRun, n) - 1);
+        }
+
+        int tile_passes = 0;
+        for (int lo = 0; lo < n; lo += tile) {
+            int hi = std::min(lo + tile, n);
+            int* tile_src = src;
+            int* tile_dst = dst;
+            tile_passes = 0;
+            for (int width = kRun; width < tile; width *= 2) {
+                merge_pass(tile_src, tile_dst, lo, hi, width);
+                std::swap(tile_src, tile_dst);
+                tile_passes++;
+            }
+        }
+        if (tile_passes % 2 == 1) {
+            std::swap(src, dst);
+        }
+
+        for (int width = tile; width < n; width *= 2) {
+            merge_pass(src, dst, 0, n, width);
+            std::swap(src, dst);
+        }
+    }
+
+    // Number of elements of a[0, n) that are <= key (upper bound), found by
+    // exponential search from the front: O(log d) for an answer d.
+    static int gallop_right(int key, const int* a, int n) {
+        int hi = 1;
+        while (hi <= n && a[hi - 1] <= key) {
+            hi *= 2;
+        }
+        int lo = hi / 2;
+        return std::upper_bound(a + lo, a + std::min(hi, n), key) - a;
+    }
+
+    // Number of elements of a[0, n) that are < key (lower bound).
+    static int gallop_left(int key, const int* a, int n) {
+        int hi = 1;
+        while (hi <= n && a[hi - 1] < key) {
+            hi *= 2;
+        }
+        int lo = hi / 2;
+        return std::lower_bound(a + lo, a + std::min(hi, n), key) - a;
+    }
+
+    // Minimum run length as in TimSort: the top six bits of n, rounded up,
+    // so n / min_run is a power of two or slightly less.
+    static int min_run_length(int n) {
+        int r = 0;
+        while (n >= 64) {
+            r |= n & 1;
+            n >>= 1;
+        }
+        return n + r;
+    }
+
+    // Finds the run starting at lo and makes it ascending. Equal ints are
+    // indistinguishable, so a descending run may contain ties and still be
+    // reversed.
+    static int count_run(int* arr, int lo, int n) {
+        int hi = lo + 1;
+        if (hi == n) {
+            return 1;
+        }
+        if (arr[hi] < arr[lo]) {
+            while (hi + 1 < n && arr[hi + 1] <= arr[hi]) {
+                hi++;
+            }
+            std::reverse(arr + lo, arr + hi + 1);
+        } else {
+            while (hi + 1 < n && arr[hi + 1] >= arr[hi]) {
+                hi++;
+            }
+        }
+        return hi + 1 - lo;
+    }
+
+    // Sorts [lo, hi) given that [lo, sorted) is already in order.
+    static void binary_insertion_sort(int* arr, int lo, int sorted, int hi) {
+        for (int i = sorted; i < hi; i++) {
+            int key = arr[i];
+            int* pos = std::upper_bound(arr + lo, arr + i, key);
+            std::copy_backward(pos, arr + i, arr + i + 1);
+            *pos = key;
+        }
+    }
+
+    // Powersort priority of the boundary between the runs [s1, s1 + n1) and
+    // [s1 + n1, s1 + n1 + n2): the depth at which the boundary would sit in
+    // a perfectly balanced merge tree over [0, n).
+    static int node_power(int n, int s1, int n1, int n2) {
+        long long a = 2LL * s1 + n1;
+        long long b = a + n1 + n2;
+        int power = 0;
+        while (true) {
+            power++;
+            if (a >= n) {
+                a -= n;
+                b -= n;
+            } else if (b >= n) {
+                break;
+            }
+            a *= 2;
+            b *= 2;
+        }
+        return power;
+    }
+
+    // Merges the adjacent sorted runs [lo, mid) and [mid, hi) of arr in
+    // place. Elements already in their final position at either end are cut
+    // off first; the rest of the left run is moved to the buffer and merged
+    // back, galloping while one side keeps winning.
+    void merge_galloping(int* arr, int lo, int mid, int hi) {
+        lo += gallop_right(arr[mid], arr + lo, mid - lo);
+        if (lo == mid) {
+            return;
+        }
+        hi = mid + gallop_left(arr[mid - 1], arr + mid, hi - mid);
+
+        int* left = buffer.data();
+        int left_size = mid - lo;
+        std::copy(arr + lo, arr + mid, left);
+
+        int i = 0, j = mid, k = lo;
+        int min_gallop = kMinGallop;
+        while (i < left_size && j < hi) {
+            int left_wins = 0, right_wins = 0;
+            while (i < left_size && j < hi && left_wins < min_gallop &&
+                   right_wins < min_gallop) {
+                if (arr[j] < left[i]) {
+                    arr[k++] = arr[j++];
+                    right_wins++;
+                    left_wins = 0;
+                } else {
+                    arr[k++] = left[i++];
+                    left_wins++;
+                    right_wins = 0;
+                }
+            }
+
+            while (i < left_size && j < hi) {
+                int from_left = gallop_right(arr[j], left + i, left_size - i);
+                k = std::copy(left + i, left + i + from_left, arr + k) - arr;
+                i += from_left;
+                if (i == left_size) {
+                    break;
+                }
+
+                int from_right = gallop_left(left[i], arr + j, hi - j);
+                k = std::copy(arr + j, arr + j + from_right, arr + k) - arr;
+                j += from_right;
+                if (j == hi) {
+                    break;
+                }
+
+                if (from_left < kMinGallop && from_right < kMinGallop) {
+                    min_gallop += 2;
+                    break;
+                }
+                min_gallop = std::max(1, min_gallop - 1);
+            }
+        }
+
+        std::copy(left + i, left + left_size, arr + k);
+    }
+
+    void natural_sort(std::vector<int>& arr) {
+        int n = arr.size();
+        if (n < 2) {
+            return;
+        }
+        if (buffer.size() < arr.size()) {
+            buffer.resize(arr.size());
+        }
+
+        int* data = arr.data();
+        int min_run = min_run_length(n);
+        std::vector<Run> stack;
+
+        for (int lo = 0; lo < n;) {
+            int length = count_run(data, lo, n);
+            if (length < min_run) {
+                int forced = std::min(min_run, n - lo);
+                binary_insertion_sort(data, lo, lo + length, lo + forced);
+                length = forced;
+            }
+
+            // Merge while the boundary below the top is deeper in the
+            // balanced tree than the new one.
+            if (!stack.empty()) {
+                int power = node_power(n, stack.back().start,
+                                       stack.back().length, length);
+                while (stack.size() > 1 && stack[stack.size() - 2].power > power) {
+                    Run top = stack.back();
+                    stack.pop_back();
+                    merge_galloping(data, stack.back().start, top.start,
+                                    top.start + top.length);
+                    stack.back().length += top.length;
+                }
+                stack.back().power = power;
+            }
+            stack.push_back(Run{lo, length, 0});
+            lo += length;
+        }
+
+        while (stack.size() > 1) {
+            Run top = stack.back();
+            stack.pop_back();
+            merge_galloping(data, stack.back().start, top.start,
+                            top.start + top.length);
+            stack.back().length += top.length;
+        }
+    }
+
+    void sort(std::vector<int>& arr, int threshold) {
+        int n = arr.size();
+        if (n < 2) {
+            return;
+        }
+        if (buffer.size() < arr.size()) {
+            buffer.resize(arr.size());
+        }
+        std::copy(arr.begin(), arr.end(), buffer.begin());
+        sort_into(buffer.data(), arr.data(), 0, n - 1, std::max(threshold, 1));
+    }
+
+public:
+    MergeSorter(int capacity = 0)
+        : buffer(capacity) {
+    }
+
+    void standard_merge_sort(std::vector<int>& arr) {
+        sort(arr, 1);
+    }
+
+    void hybrid_merge_sort(std::vector<int>& arr, int threshold) {
+        sort(arr, threshold);
+    }
+
+    // Uses the threshold tuned for the detected input class.
+    void hybrid_merge_sort(std::vector<int>& arr) {
+        sort(arr, thresholds.get("int", SortThresholds::classify(arr)));
+    }
+
+    void set_thresholds(const SortThresholds& tuned) {
+        thresholds = tuned;
+    }
+
+    const SortThresholds& get_thresholds() const {
+        return thresholds;
+    }
+
+    void bottom_up_merge_sort(std::vector<int>& arr) {
+        bottom_up_sort(arr);
+    }
+
+    void natural_merge_sort(std::vector<int>& arr) {
+        natural_sort(arr);
+    }
+
+};
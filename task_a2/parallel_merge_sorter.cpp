@@ -0,0 +1,112 @@
+#include <algorithm>
+#include <vector>
+
+// Parallel hybrid merge sort. The two halves of a range are sorted as
+// separate tasks down to kForkCutoff elements, below which MergeSorter's
+// sequential recursion takes over. Merges are split across the pool by
+// co-rank, so the top-level merges do not run on a single thread.
+class ParallelMergeSorter {
+private:
+    static constexpr int kForkCutoff = 1 << 15;
+    static constexpr int kMergeGrain = 1 << 15;
+
+    TaskPool pool;
+    std::vector<int> buffer;
+    SortThresholds thresholds;
+
+    // Number of elements taken from a in the first k elements of the merge
+    // of a[0, na) and b[0, nb); ties go to a, as in the sequential merge.
+    static int co_rank(int k, const int* a, int na, const int* b, int nb) {
+        int lo = std::max(0, k - nb);
+        int hi = std::min(k, na);
+        while (lo < hi) {
+            int i = lo + (hi - lo) / 2;
+            if (a[i] <= b[k - i - 1]) {
+                lo = i + 1;
+            } else {
+                hi = i;
+            }
+        }
+        return lo;
+    }
+
+    void parallel_merge(const int* src, int* dst, int left, int mid, int right) {
+        const int* a = src + left;
+        const int* b = src + mid + 1;
+        int na = mid - left + 1;
+        int nb = right - mid;
+        int total = na + nb;
+
+        int chunks = std::min(pool.size() * 4, total / kMergeGrain);
+        if (chunks <= 1) {
+            MergeSorter::merge_runs(a, na, b, nb, dst + left);
+            return;
+        }
+
+        TaskGroup group;
+        for (int c = 0; c < chunks; c++) {
+            int k_begin = (long long)total * c / chunks;
+            int k_end = (long long)total * (c + 1) / chunks;
+            pool.spawn(group, [=] {
+                int i_begin = co_rank(k_begin, a, na, b, nb);
+                int i_end = co_rank(k_end, a, na, b, nb);
+                int j_begin = k_begin - i_begin;
+                int j_end = k_end - i_end;
+                MergeSorter::merge_runs(a + i_begin, i_end - i_begin, b + j_begin,
+                                        j_end - j_begin, dst + left + k_begin);
+            });
+        }
+        pool.wait(group);
+    }
+
+    // Same contract as MergeSorter::sort_into.
+    void sort_into(int* src, int* dst, int left, int right, int threshold) {
+        if (right - left + 1 <= kForkCutoff) {
+            MergeSorter::sort_into(src, dst, left, right, threshold);
+            return;
+        }
+
+        int mid = left + (right - left) / 2;
+        TaskGroup group;
+        pool.spawn(group, [=] { sort_into(dst, src, left, mid, threshold); });
+        sort_into(dst, src, mid + 1, right, threshold);
+        pool.wait(group);
+
+        if (src[mid] <= src[mid + 1]) {
+            std::copy(src + left, src + right + 1, dst + left);
+        } else {
+            parallel_merge(src, dst, left, mid, right);
+        }
+    }
+
+public:
+    ParallelMergeSorter(int threads = std::thread::hardware_concurrency())
+        : pool(threads) {
+    }
+
+    int threads() const {
+        return pool.size();
+    }
+
+    void hybrid_merge_sort(std::vector<int>& arr, int threshold) {
+        int n = arr.size();
+        if (n < 2) {
+            return;
+        }
+        if (buffer.size() < arr.size()) {
+            buffer.resize(arr.size());
+        }
+        std::copy(arr.begin(), arr.end(), buffer.begin());
+        sort_into(buffer.data(), arr.data(), 0, n - 1, std::max(threshold, 1));
+    }
+
+    // Same tuned threshold as MergeSorter::hybrid_merge_sort(arr).
+    void hybrid_merge_sort(std::vector<int>& arr) {
+        hybrid_merge_sort(arr, thresholds.get("int", SortThresholds::classify(arr)));
+    }
+
+    void set_thresholds(const SortThresholds& tuned) {
+        thresholds = tuned;
+    }
+
+};
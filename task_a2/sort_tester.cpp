@@ -2,89 +2,26 @@
 #include <chrono>
 #include <fstream>
 #include <iostream>
+#include <thread>
 #include <vector>
 
 class ArrayGenerator;
 
 class SortTester {
 private:
-    ArrayGenerator* generator;
-
-    void standard_merge(std::vector<int>& arr, int left, int mid, int right) {
-        int n1 = mid - left + 1;
-        int n2 = right - mid;
-
-        std::vector<int> left_arr(n1);
-        std::vector<int> right_arr(n2);
-
-        for (int i = 0; i < n1; i++)
-            left_arr[i] = arr[left + i];
-        for (int i = 0; i < n2; i++)
-            right_arr[i] = arr[mid + 1 + i];
-
-        int i = 0, j = 0, k = left;
-
-        while (i < n1 && j < n2) {
-            if (left_arr[i] <= right_arr[j]) {
-                arr[k] = left_arr[i];
-                i++;
-            } else {
-                arr[k] = right_arr[j];
-                j++;
-            }
-            k++;
-        }
-
-        while (i < n1) {
-            arr[k] = left_arr[i];
-            i++;
-            k++;
-        }
-
-        while (j < n2) {
-            arr[k] = right_arr[j];
-            j++;
-            k++;
-        }
-    }
-
-    void standard_merge_sort(std::vector<int>& arr, int left, int right) {
-        if (left < right) {
-            int mid = left + (right - left) / 2;
-            standard_merge_sort(arr, left, mid);
-            standard_merge_sort(arr, mid + 1, right);
-            standard_merge(arr, left, mid, right);
-        }
-    }
-
-    void insertion_sort(std::vector<int>& arr, int left, int right) {
-        for (int i = left + 1; i <= right; i++) {
-            int key = arr[i];
-            int j = i - 1;
-
-            while (j >= left && arr[j] > key) {
-                arr[j + 1] = arr[j];
-                j--;
-            }
-            arr[j + 1] = key;
-        }
-    }
+    const std::string THRESHOLDS_FILE = "thresholds.txt";
 
-    void hybrid_merge(std::vector<int>& arr, int left, int mid, int right) {
-        standard_merge(arr, left, mid, right);
-    }
-
-    void hybrid_merge_sort(std::vector<int>& arr, int left, int right,
-                           int threshold) {
-        if (left < right) {
-            if (right - left + 1 <= threshold) {
-                insertion_sort(arr, left, right);
-            } else {
-                int mid = left + (right - left) / 2;
-                hybrid_merge_sort(arr, left, mid, threshold);
-                hybrid_merge_sort(arr, mid + 1, right, threshold);
-                hybrid_merge(arr, left, mid, right);
-            }
+    ArrayGenerator* generator;
+    MergeSorter sorter;
+    ParallelMergeSorter parallel_sorter;
+
+    std::vector<int> get_array(const std::string& type, int size) {
+        if (type == "Random") {
+            return generator->get_random_array(size);
+        } else if (type == "Reverse_Sorted") {
+            return generator->get_reverse_sorted_array(size);
+        } else {
+            return generator->get_almost_sorted_array(size);
         }
     }
 
@@ -94,7 +31,7 @@ private:
         std::cout << "Testing on " << type << " arrays..." << std::endl;
 
         std::ofstream file(type + "_results.csv");
-        file << "Size,Standard";
+        file << "Size,Standard,Bottom_Up,Natural,Hybrid_Auto";
         for (int threshold : thresholds) {
             file << ",Hybrid_" << threshold;
         }
@@ -108,22 +45,21 @@ private:
                           << size << " elements)" << std::endl;
             }
 
-            std::vector<int> arr;
-            if (type == "Random") {
-                arr = generator->get_random_array(size);
-            } else if (type == "Reverse_Sorted") {
-                arr = generator->get_reverse_sorted_array(size);
-            } else {
-                arr = generator->get_almost_sorted_array(size);
-            }
+            std::vector<int> arr = get_array(type, size);
 
             long long standard_time = 0;
+            long long bottom_up_time = 0;
+            long long natural_time = 0;
+            long long auto_time = 0;
             std::vector<long long> hybrid_times(thresholds.size(), 0);
 
             const int RUNS = 3;
             for (int run = 0; run < RUNS; run++) {
                 std::vector<int> test_arr = arr;
                 standard_time += test_standard_merge_sort(test_arr);
+                bottom_up_time += test_bottom_up_merge_sort(test_arr);
+                natural_time += test_natural_merge_sort(test_arr);
+                auto_time += test_auto_merge_sort(test_arr);
 
                 for (size_t j = 0; j < thresholds.size(); j++) {
                     test_arr = arr;
@@ -133,7 +69,11 @@ private:
             }
 
             standard_time /= RUNS;
-            file << size << "," << standard_time;
+            bottom_up_time /= RUNS;
+            natural_time /= RUNS;
+            auto_time /= RUNS;
+            file << size << "," << standard_time << "," << bottom_up_time
+                 << "," << natural_time << "," << auto_time;
 
             for (size_t j = 0; j < thresholds.size(); j++) {
                 hybrid_times[j] /= RUNS;
@@ -147,14 +87,28 @@ private:
                   << std::endl;
     }
 
+    // Reports which sort broke the order of which input, if any did.
+    bool check_sorted(const std::string& sort, const std::string& type,
+                      const std::vector<int>& result,
+                      const std::vector<int>& expected) {
+        if (result == expected) {
+            return true;
+        }
+        std::cerr << "Verification failed: " << sort << " on " << type
+                  << " array of " << expected.size() << " elements"
+                  << std::endl;
+        return false;
+    }
+
 public:
     SortTester(ArrayGenerator* gen)
-        : generator(gen) {
+        : generator(gen)
+        , sorter(100000) {
     }
 
     long long test_standard_merge_sort(std::vector<int> arr) {
         auto start = std::chrono::high_resolution_clock::now();
-        standard_merge_sort(arr, 0, arr.size() - 1);
+        sorter.standard_merge_sort(arr);
         auto elapsed = std::chrono::high_resolution_clock::now() - start;
         return std::chrono::duration_cast<std::chrono::microseconds>(elapsed)
             .count();
@@ -162,7 +116,31 @@ public:
 
     long long test_hybrid_merge_sort(std::vector<int> arr, int threshold) {
         auto start = std::chrono::high_resolution_clock::now();
-        hybrid_merge_sort(arr, 0, arr.size() - 1, threshold);
+        sorter.hybrid_merge_sort(arr, threshold);
+        auto elapsed = std::chrono::high_resolution_clock::now() - start;
+        return std::chrono::duration_cast<std::chrono::microseconds>(elapsed)
+            .count();
+    }
+
+    long long test_bottom_up_merge_sort(std::vector<int> arr) {
+        auto start = std::chrono::high_resolution_clock::now();
+        sorter.bottom_up_merge_sort(arr);
+        auto elapsed = std::chrono::high_resolution_clock::now() - start;
+        return std::chrono::duration_cast<std::chrono::microseconds>(elapsed)
+            .count();
+    }
+
+    long long test_natural_merge_sort(std::vector<int> arr) {
+        auto start = std::chrono::high_resolution_clock::now();
+        sorter.natural_merge_sort(arr);
+        auto elapsed = std::chrono::high_resolution_clock::now() - start;
+        return std::chrono::duration_cast<std::chrono::microseconds>(elapsed)
+            .count();
+    }
+
+    long long test_auto_merge_sort(std::vector<int> arr) {
+        auto start = std::chrono::high_resolution_clock::now();
+        sorter.hybrid_merge_sort(arr);
         auto elapsed = std::chrono::high_resolution_clock::now() - start;
         return std::chrono::duration_cast<std::chrono::microseconds>(elapsed)
             .count();
@@ -186,4 +164,175 @@ public:
                   << std::endl;
     }
 
+    // Compares every sort with std::sort on sizes around the insertion-sort
+    // blocks, the AVX2 merge width, the tile and the parallel fork cutoff.
+    bool verify_sorts() {
+        std::vector<std::string> types = {"Random", "Reverse_Sorted",
+                                          "Almost_Sorted"};
+        std::vector<int> sizes = {0,    1,     2,     7,     8,     9,
+                                  15,   16,    17,    31,    33,    100,
+                                  1000, 16383, 16385, 65537, 100000};
+        bool ok = true;
+
+        std::vector<std::pair<std::string, std::vector<int>>> inputs;
+        for (const std::string& type : types) {
+            for (int size : sizes) {
+                inputs.push_back({type, get_array(type, size)});
+            }
+        }
+        inputs.push_back({"Equal", std::vector<int>(1000, 7)});
+        inputs.push_back({"Large_Random", generator->get_large_random_array(300001)});
+
+        for (const auto& [type, arr] : inputs) {
+            std::vector<int> expected = arr;
+            std::sort(expected.begin(), expected.end());
+
+            std::vector<int> result = arr;
+            sorter.standard_merge_sort(result);
+            ok &= check_sorted("standard", type, result, expected);
+
+            for (int threshold : {1, 16, 30}) {
+                result = arr;
+                sorter.hybrid_merge_sort(result, threshold);
+                ok &= check_sorted("hybrid_" + std::to_string(threshold), type,
+                                   result, expected);
+            }
+
+            result = arr;
+            sorter.hybrid_merge_sort(result);
+            ok &= check_sorted("hybrid_auto", type, result, expected);
+
+            result = arr;
+            sorter.bottom_up_merge_sort(result);
+            ok &= check_sorted("bottom_up", type, result, expected);
+
+            result = arr;
+            sorter.natural_merge_sort(result);
+            ok &= check_sorted("natural", type, result, expected);
+
+            result = arr;
+            parallel_sorter.hybrid_merge_sort(result);
+            ok &= check_sorted("parallel", type, result, expected);
+        }
+
+        if (ok) {
+            std::cout << "All sorts verified against std::sort" << std::endl;
+        }
+        return ok;
+    }
+
+    void load_thresholds() {
+        SortThresholds thresholds;
+        if (thresholds.load(THRESHOLDS_FILE)) {
+            std::cout << "Loaded thresholds from " << THRESHOLDS_FILE
+                      << std::endl;
+        }
+        sorter.set_thresholds(thresholds);
+        parallel_sorter.set_thresholds(thresholds);
+    }
+
+    // Times the hybrid sort on full-size arrays of every type with each
+    // candidate threshold and saves the fastest ones. The candidates take
+    // turns on one array rather than running in blocks, so a slow stretch of
+    // the host is spread over all of them.
+    void calibrate() {
+        std::vector<std::string> types = {"Random", "Reverse_Sorted",
+                                          "Almost_Sorted"};
+        std::vector<int> candidates = {SortThresholds::MIN_THRESHOLD, 8, 12, 16,
+                                       20, 24, 32, 40, 48, 64, 96,
+                                       SortThresholds::MAX_THRESHOLD};
+        const int RUNS = 20;
+
+        std::cout << "Calibrating thresholds..." << std::endl;
+
+        SortThresholds thresholds;
+        for (const std::string& type : types) {
+            std::vector<int> arr = get_array(type, 100000);
+            std::vector<long long> times(candidates.size(), 0);
+
+            for (int run = 0; run < RUNS; run++) {
+                for (size_t j = 0; j < candidates.size(); j++) {
+                    times[j] += test_hybrid_merge_sort(arr, candidates[j]);
+                }
+            }
+
+            size_t best = std::min_element(times.begin(), times.end()) -
+                          times.begin();
+            thresholds.set("int", type, candidates[best]);
+            std::cout << type << ": " << candidates[best] << std::endl;
+        }
+
+        thresholds.save(THRESHOLDS_FILE);
+        sorter.set_thresholds(thresholds);
+        parallel_sorter.set_thresholds(thresholds);
+        std::cout << "Thresholds saved to " << THRESHOLDS_FILE << std::endl;
+    }
+
+    // Sequential against parallel hybrid sort on arrays far larger than the
+    // ones above, for 1, 2, 4, ... threads up to the number of cores. Every
+    // parallel result is checked against the sequential one. Both sides use
+    // the tuned thresholds.
+    bool run_parallel_tests() {
+        std::vector<int> sizes = {1 << 20, 1 << 22, 1 << 24};
+
+        int cores = std::max(1u, std::thread::hardware_concurrency());
+        std::vector<int> thread_counts;
+        for (int threads = 1; threads < cores; threads *= 2) {
+            thread_counts.push_back(threads);
+        }
+        thread_counts.push_back(cores);
+
+        std::cout << "Testing parallel sort on up to " << cores
+                  << " threads..." << std::endl;
+
+        std::ofstream file("Parallel_results.csv");
+        file << "Size,Sequential";
+        for (int threads : thread_counts) {
+            file << ",Threads_" << threads;
+        }
+        file << std::endl;
+
+        std::vector<std::vector<long long>> times(sizes.size());
+        std::vector<long long> sequential_times(sizes.size());
+        std::vector<std::vector<int>> arrays, expected;
+        for (int size : sizes) {
+            arrays.push_back(generator->get_large_random_array(size));
+            expected.push_back(arrays.back());
+            sorter.hybrid_merge_sort(expected.back());
+        }
+
+        bool ok = true;
+        for (size_t i = 0; i < sizes.size(); i++) {
+            sequential_times[i] = test_auto_merge_sort(arrays[i]);
+        }
+        for (int threads : thread_counts) {
+            ParallelMergeSorter parallel(threads);
+            parallel.set_thresholds(sorter.get_thresholds());
+            for (size_t i = 0; i < sizes.size(); i++) {
+                std::vector<int> arr = arrays[i];
+                auto start = std::chrono::high_resolution_clock::now();
+                parallel.hybrid_merge_sort(arr);
+                auto elapsed = std::chrono::high_resolution_clock::now() - start;
+                times[i].push_back(
+                    std::chrono::duration_cast<std::chrono::microseconds>(elapsed)
+                        .count());
+                ok &= check_sorted("parallel_" + std::to_string(threads),
+                                   "Large_Random", arr, expected[i]);
+            }
+        }
+
+        for (size_t i = 0; i < sizes.size(); i++) {
+            file << sizes[i] << "," << sequential_times[i];
+            for (long long t : times[i]) {
+                file << "," << t;
+            }
+            file << std::endl;
+        }
+
+        file.close();
+        std::cout << "Results saved to Parallel_results.csv" << std::endl
+                  << std::endl;
+        return ok;
+    }
+
 };
@@ -0,0 +1,84 @@
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+// Insertion-sort thresholds of the hybrid merge sort per element type and
+// input class. The defaults are the best values from the sweep in README;
+// SortTester::calibrate measures them on the current host and saves them as
+// "<type> <class> <threshold>" lines.
+class SortThresholds {
+private:
+    std::map<std::string, int> values;
+
+    static std::string key(const std::string& type, const std::string& input) {
+        return type + " " + input;
+    }
+
+public:
+    // The range SortTester::calibrate searches. Values from a hand-edited or
+    // foreign file are clamped to it.
+    static constexpr int MIN_THRESHOLD = 4;
+    static constexpr int MAX_THRESHOLD = 128;
+
+    static int clamp(int threshold) {
+        return std::clamp(threshold, MIN_THRESHOLD, MAX_THRESHOLD);
+    }
+
+    SortThresholds() {
+        set("int", "Random", 30);
+        set("int", "Reverse_Sorted", 20);
+        set("int", "Almost_Sorted", 50);
+    }
+
+    int get(const std::string& type, const std::string& input) const {
+        auto it = values.find(key(type, input));
+        return it == values.end() ? 30 : it->second;
+    }
+
+    void set(const std::string& type, const std::string& input, int threshold) {
+        values[key(type, input)] = clamp(threshold);
+    }
+
+    bool load(const std::string& path) {
+        std::ifstream in(path);
+        if (!in) {
+            return false;
+        }
+        std::string type, input;
+        int threshold;
+        while (in >> type >> input >> threshold) {
+            set(type, input, threshold);
+        }
+        return true;
+    }
+
+    void save(const std::string& path) const {
+        std::ofstream out(path);
+        for (const auto& [name, threshold] : values) {
+            out << name << " " << threshold << std::endl;
+        }
+    }
+
+    // Guesses the input class from up to 1024 adjacent pairs, so the check
+    // costs next to nothing compared with the sort itself. Equal neighbours
+    // say nothing about the order and are not counted.
+    static std::string classify(const std::vector<int>& arr) {
+        int n = arr.size();
+        int step = std::max(1, n / 1024);
+        int ascents = 0, descents = 0;
+        for (int i = 0; i + 1 < n; i += step) {
+            ascents += arr[i] < arr[i + 1];
+            descents += arr[i] > arr[i + 1];
+        }
+        if (descents * 3 <= ascents + descents) {
+            return "Almost_Sorted";
+        }
+        if (ascents * 3 <= ascents + descents) {
+            return "Reverse_Sorted";
+        }
+        return "Random";
+    }
+
+};
@@ -0,0 +1,181 @@
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Counts the unfinished tasks spawned into it; TaskPool::wait blocks on it
+// and rethrows the first exception one of the tasks threw.
+class TaskGroup {
+private:
+    friend class TaskPool;
+
+    std::atomic<int> pending{0};
+    std::mutex error_mutex;
+    std::exception_ptr error;
+};
+
+// Work-stealing pool: every thread pushes and pops at the back of its own
+// deque and steals from the front of the others. The thread that calls wait
+// runs tasks too, so a task may spawn and wait on subtasks without blocking
+// a worker.
+class TaskPool {
+private:
+    struct Task {
+        std::function<void()> fn;
+        TaskGroup* group;
+    };
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    static inline thread_local const TaskPool* owner = nullptr;
+    static inline thread_local int owner_index = 0;
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<int> queued{0};
+    std::atomic<bool> stopping{false};
+    std::mutex sleep_mutex;
+    std::condition_variable wake;
+
+    // Threads outside the pool share queue 0.
+    int current_index() const {
+        return owner == this ? owner_index : 0;
+    }
+
+    bool try_pop(int index, bool steal, Task& task) {
+        Queue& queue = *queues[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            return false;
+        }
+        if (steal) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        } else {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+        queued--;
+        return true;
+    }
+
+    bool try_run(int index) {
+        Task task;
+        int n = queues.size();
+        bool found = try_pop(index, false, task);
+        for (int k = 1; k < n && !found; k++) {
+            found = try_pop((index + k) % n, true, task);
+        }
+        if (!found) {
+            return false;
+        }
+        run_task(task);
+        return true;
+    }
+
+    // The group is always marked finished, even when the task throws, so its
+    // waiter cannot hang; the exception goes to the waiter instead.
+    void run_task(Task& task) {
+        TaskGroup& group = *task.group;
+        try {
+            task.fn();
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(group.error_mutex);
+            if (!group.error) {
+                group.error = std::current_exception();
+            }
+        }
+        if (group.pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            {
+                std::lock_guard<std::mutex> lock(sleep_mutex);
+            }
+            wake.notify_all();
+        }
+    }
+
+    void worker_loop(int index) {
+        owner = this;
+        owner_index = index;
+        while (true) {
+            if (try_run(index)) {
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleep_mutex);
+            wake.wait(lock, [this] { return stopping || queued > 0; });
+            if (stopping && queued == 0) {
+                return;
+            }
+        }
+    }
+
+public:
+    TaskPool(int threads = std::thread::hardware_concurrency()) {
+        threads = std::max(threads, 1);
+        for (int i = 0; i < threads; i++) {
+            queues.push_back(std::make_unique<Queue>());
+        }
+        for (int i = 1; i < threads; i++) {
+            workers.emplace_back(&TaskPool::worker_loop, this, i);
+        }
+    }
+
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    ~TaskPool() {
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    int size() const {
+        return queues.size();
+    }
+
+    void spawn(TaskGroup& group, std::function<void()> fn) {
+        group.pending.fetch_add(1, std::memory_order_relaxed);
+        Queue& queue = *queues[current_index()];
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back(Task{std::move(fn), &group});
+        }
+        queued++;
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex);
+        }
+        wake.notify_one();
+    }
+
+    // Runs queued tasks while the group is unfinished and sleeps when there
+    // are none, i.e. while the remaining tasks run on other threads.
+    void wait(TaskGroup& group) {
+        int index = current_index();
+        while (group.pending.load(std::memory_order_acquire) > 0) {
+            if (try_run(index)) {
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleep_mutex);
+            wake.wait(lock, [&] {
+                return group.pending.load(std::memory_order_acquire) == 0 ||
+                       queued > 0;
+            });
+        }
+        if (group.error) {
+            std::rethrow_exception(group.error);
+        }
+    }
+
+};
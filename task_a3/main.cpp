@@ -3,6 +3,7 @@
 #include <cmath>
 #include <fstream>
 #include <iostream>
+#include <map>
 #include <random>
 #include <string>
 #include <vector>
@@ -11,6 +12,60 @@ using namespace std;
 
 mt19937 rng((uint32_t)chrono::steady_clock::now().time_since_epoch().count());
 
+// Size below which introsort switches to insertion sort, per element type and
+// input class. The defaults are replaced by `main calibrate`, which measures
+// them on this host and saves them to CUTOFFS_FILE.
+const string CUTOFFS_FILE = "cutoffs.txt";
+map<string, int> introsort_cutoffs = {
+    {"int random", 16},
+    {"int sorted", 16},
+    {"int reverse", 16},
+};
+
+// The range `main calibrate` searches; cutoffs read from a hand-edited or
+// foreign file are clamped to it.
+const int MIN_CUTOFF = 4;
+const int MAX_CUTOFF = 128;
+
+// Guesses the input class from up to 1024 adjacent pairs; equal neighbours
+// are not counted.
+string classify_input(const vector<int>& arr) {
+    int n = (int)arr.size();
+    int step = max(1, n / 1024);
+    int ascents = 0, descents = 0;
+    for (int i = 0; i + 1 < n; i += step) {
+        ascents += arr[i] < arr[i + 1];
+        descents += arr[i] > arr[i + 1];
+    }
+    if (descents * 3 <= ascents + descents) {
+        return "sorted";
+    }
+    if (ascents * 3 <= ascents + descents) {
+        return "reverse";
+    }
+    return "random";
+}
+
+bool load_cutoffs(const string& path) {
+    ifstream in(path);
+    if (!in) {
+        return false;
+    }
+    string type, category;
+    int cutoff;
+    while (in >> type >> category >> cutoff) {
+        introsort_cutoffs[type + " " + category] = clamp(cutoff, MIN_CUTOFF, MAX_CUTOFF);
+    }
+    return true;
+}
+
+void save_cutoffs(const string& path) {
+    ofstream out(path);
+    for (const auto& [key, cutoff] : introsort_cutoffs) {
+        out << key << " " << cutoff << "\n";
+    }
+}
+
 void insertion_sort(vector<int>& arr, int left, int right) {
     for (int i = left + 1; i <= right; i++) {
         int key = arr[i];
@@ -100,12 +155,13 @@ void quicksort(vector<int>& arr) {
     qs_rec(arr, 0, (int)arr.size() - 1);
 }
 
-void introsort_impl(vector<int>& arr, int left, int right, int depth_limit) {
+void introsort_impl(vector<int>& arr, int left, int right, int depth_limit,
+                    int cutoff) {
     if (left >= right)
         return;
     int size = right - left + 1;
 
-    if (size < 16) {
+    if (size < cutoff) {
         insertion_sort(arr, left, right);
         return;
     }
@@ -117,17 +173,21 @@ void introsort_impl(vector<int>& arr, int left, int right, int depth_limit) {
 
     int pivot_index = part_rand(arr, left, right);
 
-    introsort_impl(arr, left, pivot_index - 1, depth_limit - 1);
-    introsort_impl(arr, pivot_index + 1, right, depth_limit - 1);
+    introsort_impl(arr, left, pivot_index - 1, depth_limit - 1, cutoff);
+    introsort_impl(arr, pivot_index + 1, right, depth_limit - 1, cutoff);
 }
 
-void introsort(vector<int>& arr) {
+void introsort(vector<int>& arr, int cutoff) {
     int n = (int)arr.size();
     if (n <= 1)
         return;
 
     int depth_limit = 2 * (int)floor(log2(n));
-    introsort_impl(arr, 0, n - 1, depth_limit);
+    introsort_impl(arr, 0, n - 1, depth_limit, cutoff);
+}
+
+void introsort(vector<int>& arr) {
+    introsort(arr, introsort_cutoffs["int " + classify_input(arr)]);
 }
 
 vector<int> generate_random(int n) {
@@ -171,6 +231,32 @@ public:
             .count();
     }
 
+    long long measure_introsort(vector<int> arr, int cutoff) const {
+        auto start = Clock::now();
+        introsort(arr, cutoff);
+        auto finish = Clock::now();
+        return chrono::duration_cast<chrono::nanoseconds>(finish - start)
+            .count();
+    }
+
+    // Picks the cutoff with the smallest total time over `repeats` arrays of
+    // size n from gen, trying every candidate on each array.
+    template <typename Generator>
+    int calibrate(Generator gen, int n, int repeats) const {
+        vector<int> cutoffs = {MIN_CUTOFF, 8, 12, 16, 24, 32, 48, 64, 96, MAX_CUTOFF};
+        vector<long long> total(cutoffs.size(), 0);
+
+        for (int r = 0; r < repeats; ++r) {
+            vector<int> base = gen(n);
+            for (size_t i = 0; i < cutoffs.size(); ++i) {
+                total[i] += measure_introsort(base, cutoffs[i]);
+            }
+        }
+
+        size_t best = min_element(total.begin(), total.end()) - total.begin();
+        return cutoffs[best];
+    }
+
     template <typename Generator>
     void run(const string& category, Generator gen, const vector<int>& sizes,
              int repeats, ostream& out) const {
@@ -191,12 +277,29 @@ public:
     }
 };
 
-int main() {
+int main(int argc, char* argv[]) {
     ios::sync_with_stdio(false);
     cin.tie(nullptr);
 
     SortTester tester;
 
+    if (argc > 1 && string(argv[1]) == "calibrate") {
+        int n = 50000, repeats = 20;
+        introsort_cutoffs["int random"] =
+            tester.calibrate(generate_random, n, repeats);
+        introsort_cutoffs["int sorted"] =
+            tester.calibrate(generate_sorted, n, repeats);
+        introsort_cutoffs["int reverse"] =
+            tester.calibrate(generate_reverse_sorted, n, repeats);
+        save_cutoffs(CUTOFFS_FILE);
+        for (const auto& [key, cutoff] : introsort_cutoffs) {
+            cout << key << ": " << cutoff << "\n";
+        }
+        cout << "Saved to " << CUTOFFS_FILE << "\n";
+        return 0;
+    }
+    load_cutoffs(CUTOFFS_FILE);
+
     vector<int> sizes = {1000, 5000, 10000, 20000, 50000};
     int repeats = 10;
 